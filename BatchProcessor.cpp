@@ -0,0 +1,272 @@
+/**
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "BatchProcessor.h"
+#include <filesystem>
+#include <chrono>
+
+/**
+ * @return the milliseconds elapsed since start
+ */
+static double millisecondsSince(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Constructor
+ *
+ * @param options The settings applied to every file.
+ * @param workers The number of labeler threads, 0 uses every hardware thread.
+ * @param queueDepth The capacity of each queue between the stages.
+ */
+BatchProcessor::BatchProcessor(const BatchOptions & options, int workers, int queueDepth):
+    options(options),
+    workerCount(workers > 0 ? workers : std::max(1u, std::thread::hardware_concurrency())),
+    queueDepth(std::max(1, queueDepth))
+{}
+
+/**
+ * Reader stage - decodes result.fileName into the processor.
+ *
+ * @return true if the file was read.
+ */
+bool BatchProcessor::readStage(PGMimageProcessor & processor, BatchResult & result) const{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool readFile;
+    if(processor.isPPMFile(result.fileName)){
+        readFile = processor.readPGM<true>(result.fileName);
+    }else{
+        readFile = processor.readPGM<false>(result.fileName);
+    }
+    result.milliseconds += millisecondsSince(start);
+    return readFile;
+}
+
+/**
+ * Labeler stage - picks the threshold, extracts the components and filters them.
+ */
+void BatchProcessor::labelStage(PGMimageProcessor & processor, BatchResult & result) const{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    result.threshold = options.autoThreshold ? processor.getOtsuThreshold() : options.threshold;
+    processor.extractComponents(result.threshold, options.minSize, options.engine, options.connectivity);
+    if(options.filterComponents){
+        processor.filterComponentsBySize(options.minSize, options.maxSize);
+    }
+    result.milliseconds += millisecondsSince(start);
+}
+
+/**
+ * Writer stage - writes the requested outputs and fills in the summary.
+ * The file fails if any of its outputs cannot be written, and the first one that failed is named in result.error.
+ */
+void BatchProcessor::writeStage(PGMimageProcessor & processor, BatchResult & result) const{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const std::string & fileName = result.fileName;
+    result.success = true;
+    //records an output that could not be written
+    auto check = [&](bool written, const std::string & outputFileName){
+        if(!written && result.success){
+            result.success = false;
+            result.error = "Failed to write " + outputFileName;
+        }
+    };
+    if(!options.outputFile.empty()){
+        std::string name = outputName(options.outputFile, fileName);
+        check(processor.writeComponents<bool>(name), name);
+    }
+    if(!options.ppmImageName.empty()){
+        std::string name = outputName(options.ppmImageName, fileName);
+        check(processor.writeComponents<bool, true>(name), name);
+    }
+    if(!options.labelImageName.empty()){
+        std::string name = outputName(options.labelImageName, fileName);
+        check(processor.writeLabelImage(name), name);
+    }
+    if(!options.componentFileName.empty()){
+        std::string name = outputName(options.componentFileName, fileName);
+        check(processor.writeComponentFile(name), name);
+    }
+
+    result.components = processor.getComponentCount();
+    result.smallest = processor.getSmallestSize();
+    result.largest = processor.getLargestSize();
+    result.milliseconds += millisecondsSince(start);
+}
+
+/**
+ * Runs one file through every stage on the calling thread.
+ *
+ * @param processor The processor to use, its previous image and components are replaced.
+ * @param fileName The PGM or PPM file to process.
+ * @return The summary of the file.
+ */
+BatchResult BatchProcessor::processFile(PGMimageProcessor & processor, const std::string & fileName) const{
+    BatchResult result;
+    result.fileName = fileName;
+    if(readStage(processor, result)){
+        labelStage(processor, result);
+        writeStage(processor, result);
+    }else{
+        result.error = "Failed to load file.";
+    }
+    return result;
+}
+
+/**
+ * Processes every file through the pipeline.
+ *
+ * The reader takes a free processor, decodes the next file into it and queues it for the labelers.
+ * Each labeler labels whatever file is next in the label queue and queues it for the writer, which
+ * writes it, reports it and hands its processor back to the reader. A file that cannot be read is
+ * passed along unlabeled, so every file is reported by the writer.
+ *
+ * @param fileNames The files to process.
+ * @param callback Receives each file's summary as soon as it is written.
+ * @return The summary of every file, in the order of fileNames.
+ */
+std::vector<BatchResult> BatchProcessor::run(const std::vector<std::string> & fileNames, const ResultCallback & callback){
+    std::vector<BatchResult> results(fileNames.size());
+    int labelers = std::max(1, std::min(workerCount, static_cast<int>(fileNames.size())));
+
+    //one processor per labeler and one per queue slot, which bounds the files in flight
+    std::vector<PGMimageProcessor> processors(labelers + queueDepth);
+    BoundedQueue<PGMimageProcessor *> freeProcessors(processors.size());
+    for(PGMimageProcessor & processor : processors){
+        processor.setLoadMode(options.loadMode);
+        processor.setThreadCount(options.threadsPerFile);
+        freeProcessors.push(&processor);
+    }
+    BoundedQueue<BatchJob> labelQueue(queueDepth), writeQueue(queueDepth);
+
+    std::thread writer([&](){
+        BatchJob job;
+        while(writeQueue.pop(job)){
+            if(job.result.success){
+                writeStage(*job.processor, job.result);
+            }
+            results[job.index] = job.result;
+            callback(job.result);
+            freeProcessors.push(job.processor);
+        }
+    });
+
+    std::vector<std::thread> labelerThreads;
+    for(int i = 0; i < labelers; ++i){
+        labelerThreads.emplace_back([&](){
+            BatchJob job;
+            while(labelQueue.pop(job)){
+                if(job.result.success){
+                    labelStage(*job.processor, job.result);
+                }
+                writeQueue.push(std::move(job));
+            }
+        });
+    }
+
+    //the reader runs on the calling thread
+    for(size_t i = 0; i < fileNames.size(); ++i){
+        BatchJob job;
+        job.index = i;
+        job.result.fileName = fileNames[i];
+        freeProcessors.pop(job.processor);
+        //success marks a readable file until the writer fills in the summary
+        job.result.success = readStage(*job.processor, job.result);
+        if(!job.result.success){
+            job.result.error = "Failed to load file.";
+        }
+        labelQueue.push(std::move(job));
+    }
+    labelQueue.close();
+    for(std::thread & labeler : labelerThreads){
+        labeler.join();
+    }
+    writeQueue.close();
+    writer.join();
+
+    for(const PGMimageProcessor & processor : processors){
+        stats.merge(processor.getStats());
+    }
+    return results;
+}
+
+/**
+ * @return the phase counters of every file processed by run
+ */
+const ProcessingStats & BatchProcessor::getStats() const{
+    return stats;
+}
+
+/**
+ * @return the number of labeler threads
+ */
+int BatchProcessor::getWorkerCount() const{
+    return workerCount;
+}
+
+/**
+ * Sets the capacity of each queue between the stages.
+ */
+void BatchProcessor::setQueueDepth(int depth){
+    queueDepth = std::max(1, depth);
+}
+
+/**
+ * @return the capacity of each queue between the stages
+ */
+int BatchProcessor::getQueueDepth() const{
+    return queueDepth;
+}
+
+/**
+ * Counts the files that can be in flight at once: one being labeled by each labeler, and queueDepth
+ * more being read, waiting in a queue or being written. The reader only decodes a file once a
+ * processor is free, so this also bounds the decoded images held at once. A batch of fewer files
+ * than workers starts fewer labelers, and so fewer processors.
+ *
+ * @return the most processors the pipeline allocates
+ */
+int BatchProcessor::getProcessorCount() const{
+    return workerCount + queueDepth;
+}
+
+/**
+ * Lists the .pgm and .ppm files directly inside a directory.
+ *
+ * @param directory The directory to list.
+ * @param fileNames Receives the paths of the images, sorted by name.
+ * @return true if the directory was read; false if otherwise.
+ */
+bool BatchProcessor::listImages(const std::string & directory, std::vector<std::string> & fileNames){
+    std::error_code error;
+    std::filesystem::directory_iterator entries(directory, error);
+    if(error){
+        std::cerr << "Failed to read directory: " << directory << " (" << error.message() << ")" << "\n";
+        return false;
+    }
+
+    std::vector<std::string> images;
+    for(const std::filesystem::directory_entry & entry : entries){
+        std::string extension = entry.path().extension().string();
+        if(entry.is_regular_file(error) && (extension == ".pgm" || extension == ".ppm")){
+            images.push_back(entry.path().string());
+        }
+    }
+    std::sort(images.begin(), images.end());
+    fileNames.insert(fileNames.end(), images.begin(), images.end());
+    return true;
+}
+
+/**
+ * Builds the output name for one input of a batch, so the outputs of different files do not overwrite each other.
+ * The input's extension is dropped, since each writer adds the extension of its own output.
+ *
+ * @param prefix The output name given on the command line.
+ * @param fileName The input file.
+ * @return prefix + "_" + the file name of fileName without its extension, e.g. "out/comp" and "in/Birds-1.pgm" give "out/comp_Birds-1".
+ */
+std::string BatchProcessor::outputName(const std::string & prefix, const std::string & fileName){
+    return prefix + "_" + std::filesystem::path(fileName).stem().string();
+}
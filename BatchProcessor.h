@@ -0,0 +1,146 @@
+#ifndef _BATCHPROCESSOR_H
+#define _BATCHPROCESSOR_H
+#include "PGMimageProcessor.h"
+#include "BoundedQueue.h"
+#include <functional>
+
+/**
+ * Settings applied to every file of a batch, the same ones findcomp takes for a single file.
+ * Output names are prefixes, the name of each input file is added to them (see BatchProcessor::outputName).
+ */
+struct BatchOptions{
+    int threshold = 128;
+    bool autoThreshold = false; //pick each file's threshold with Otsu's method
+    int minSize = 1;
+    int maxSize = std::numeric_limits<int>::max();
+    bool filterComponents = false;
+    LabelingEngine engine = LabelingEngine::BFS;
+    int connectivity = 4;
+    LoadMode loadMode = LoadMode::Auto;
+    int threadsPerFile = 1; //labeling threads used for each file
+    std::string outputFile; //-w prefix, empty to not write the components
+    std::string ppmImageName; //-b prefix, empty to not write the bounding boxes
+    std::string labelImageName; //-l prefix, empty to not write the label image
+    std::string componentFileName; //-x prefix, empty to not write the component file
+};
+
+/**
+ * Summary of one file of a batch
+ */
+struct BatchResult{
+    std::string fileName;
+    bool success = false; //false if the file could not be read or an output could not be written
+    std::string error; //why the file failed, empty if it succeeded
+    int threshold = 0; //threshold the file was labeled at
+    int components = 0;
+    int smallest = 0;
+    int largest = 0;
+    double milliseconds = 0; //time spent reading, labeling and writing the file (not waiting in the queues)
+};
+
+/**
+ * BatchProcessor class
+ *
+ * Runs findcomp over many files in one process as a three-stage pipeline:
+ *
+ *   reader -> [label queue] -> labelers -> [write queue] -> writer
+ *
+ * One reader thread decodes the files in order, a pool of labeler threads extracts the
+ * components, and one writer thread writes the outputs and reports each file. The queues
+ * between the stages are bounded, so while file N is being labeled, file N+1 is already
+ * being read and file N-1 written, and disk I/O overlaps with labeling.
+ *
+ * Every file in flight holds a PGMimageProcessor from a fixed pool, which is handed back to
+ * the reader once the file is written. The pool has one processor per labeler plus one per
+ * queue slot (see getProcessorCount), and the reader waits for a free one before decoding the
+ * next file, so at most workers + queue depth decoded images, each with its components, exist
+ * at once. Processors are reused across files, so their buffers are allocated once.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+class BatchProcessor{
+    public:
+        //Receives each file's summary as soon as the file is written (always called from the writer thread)
+        typedef std::function<void(const BatchResult & result)> ResultCallback;
+
+    private:
+        /**
+         * A file moving through the pipeline, with the processor that holds its image
+         */
+        struct BatchJob{
+            size_t index; //position of the file in the batch
+            PGMimageProcessor * processor;
+            BatchResult result;
+        };
+
+        BatchOptions options;
+        int workerCount; //number of labeler threads
+        int queueDepth; //capacity of each queue between the stages
+        ProcessingStats stats; //phase counters of every processor, added up after each run
+
+        //Pipeline stages, each adds its time to the job's result
+        bool readStage(PGMimageProcessor & processor, BatchResult & result) const;
+        void labelStage(PGMimageProcessor & processor, BatchResult & result) const;
+        void writeStage(PGMimageProcessor & processor, BatchResult & result) const;
+
+    public:
+        /**
+         * Constructor
+         * @param workers the number of labeler threads, 0 uses every hardware thread
+         * @param queueDepth the capacity of each queue between the stages
+         */
+        BatchProcessor(const BatchOptions & options, int workers = 0, int queueDepth = 2);
+
+        /**
+         * Reads, labels and writes one file with the given processor
+         * @return the summary of the file
+         */
+        BatchResult processFile(PGMimageProcessor & processor, const std::string & fileName) const;
+
+        /**
+         * Processes every file through the read/label/write pipeline
+         * @return the summary of every file, in the order of fileNames
+         */
+        std::vector<BatchResult> run(const std::vector<std::string> & fileNames, const ResultCallback & callback);
+
+        /**
+         * @return the phase counters of every file processed by run, added up over all runs
+         */
+        const ProcessingStats & getStats() const;
+
+        /**
+         * @return the number of labeler threads
+         */
+        int getWorkerCount() const;
+
+        /**
+         * Sets the capacity of each queue between the stages (at least 1).
+         * Deeper queues let a stage run further ahead of the next one, at the cost of one more decoded image per slot.
+         */
+        void setQueueDepth(int depth);
+
+        /**
+         * @return the capacity of each queue between the stages
+         */
+        int getQueueDepth() const;
+
+        /**
+         * @return the most processors (and so decoded images) the pipeline keeps: one per labeler and one per queue slot
+         */
+        int getProcessorCount() const;
+
+        /**
+         * Lists the PGM and PPM files of a directory, sorted by name
+         * @return false if the directory cannot be read
+         */
+        static bool listImages(const std::string & directory, std::vector<std::string> & fileNames);
+
+        /**
+         * @return the output name for an input file: prefix + "_" + the file's name without its directory or extension
+         */
+        static std::string outputName(const std::string & prefix, const std::string & fileName);
+};
+
+#endif
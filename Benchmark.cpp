@@ -0,0 +1,482 @@
+/**
+ * Benchmarks for the image processing pipeline.
+ *
+ * Usage: bench [--sizes 1,4,16] [--patterns noise,blobs,spiral,checkerboard] [--engine bfs|unionfind|runs] [--threads N] [--reps N] [--kernels] [--frames N]
+ *
+ * Suite - generates a synthetic PGM for every size (in megapixels, 1 to 256) and pattern, then
+ * times readPGM, extractComponents, the size index, filterComponentsBySize and the PGM, PPM and bounding box
+ * PPM outputs, reporting the median and p99 latency and the throughput in megapixels per second, and counts
+ * the heap allocations of one extractComponents call and of each plain output.
+ *
+ * With --frames, N small frames are labeled one after another by one processor through reset(),
+ * as a video would be, reporting the allocations per frame and the peak resident memory as the run goes on.
+ *
+ * With --kernels, three micro-benchmarks are run first:
+ *
+ * Thresholding - compares the original byte-per-pixel loop (copy the image, then
+ * write 0/255 into every byte) with the packed bitmap kernels, in bytes of input
+ * per CPU cycle (timestamp counter cycles on x86, nanoseconds elsewhere).
+ *
+ * RGB to grey - compares the original floating point conversion with the
+ * fixed-point GreyConverter kernels, in pixels per CPU cycle.
+ *
+ * Connectivity - times every labeling engine with 4- and 8-connectivity on a
+ * random noise image, where diagonal neighbours matter the most.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "ForegroundBitmap.h"
+#include "PGMimageProcessor.h"
+#include "ImageGenerator.h"
+#include "GreyConverter.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+#include <cmath>
+#include <limits>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC
+#endif
+
+//number of calls to operator new since the program started
+static std::atomic<unsigned long long> allocationCount(0);
+
+/**
+ * Replaces the global operator new (and so new[] and every standard container) with one that counts its calls.
+ */
+void * operator new(std::size_t size){
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if(void * memory = std::malloc(size == 0 ? 1 : size)){
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void * memory) noexcept{
+    std::free(memory);
+}
+
+void operator delete(void * memory, std::size_t) noexcept{
+    std::free(memory);
+}
+
+/**
+ * @return a cycle count (x86 timestamp counter) or nanoseconds where there is no counter
+ */
+static unsigned long long readCycles(){
+#ifdef BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * Runs a kernel repetitions times and returns the median number of cycles per run.
+ */
+static double medianCycles(int repetitions, const std::function<void()> & kernel){
+    kernel(); //warm up the caches and page in the buffers
+    std::vector<unsigned long long> samples;
+    for(int i = 0; i < repetitions; ++i){
+        unsigned long long start = readCycles();
+        kernel();
+        samples.push_back(readCycles() - start);
+    }
+    std::sort(samples.begin(), samples.end());
+    return static_cast<double>(samples[samples.size() / 2]);
+}
+
+/**
+ * The thresholding loop extractComponents used before the bitmap kernels,
+ * a full copy of the image followed by one byte written per pixel.
+ */
+static void thresholdBytes(const std::vector<unsigned char> & imageData, unsigned char threshold, std::vector<unsigned char> & binaryImage){
+    binaryImage = imageData;
+    for(size_t i = 0; i<binaryImage.size(); ++i){
+        if(binaryImage[i] >= threshold){
+            binaryImage[i] = 255; //foreground
+        }else{
+            binaryImage[i] = 0; //background
+        }
+    }
+}
+
+/**
+ * Benchmarks every threshold kernel on a random image and prints bytes/cycle for each.
+ */
+static void benchmarkThreshold(int width, int height, int repetitions){
+    std::vector<unsigned char> image(static_cast<size_t>(width) * height);
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> pixel(0, 255);
+    for(unsigned char & value : image){
+        value = static_cast<unsigned char>(pixel(random));
+    }
+    const unsigned char threshold = 128;
+    const double bytes = static_cast<double>(image.size());
+
+    std::cout << "Threshold " << width << "x" << height << " (" << repetitions << " runs, median)\n";
+    std::cout << std::left << std::setw(22) << "  kernel" << std::setw(14) << "bytes/cycle" << "speedup\n";
+
+    std::vector<unsigned char> binaryImage;
+    double baseline = medianCycles(repetitions, [&](){ thresholdBytes(image, threshold, binaryImage); });
+    std::cout << std::left << std::setw(22) << "  byte loop (old)" << std::setw(14) << std::fixed << std::setprecision(3) << bytes / baseline << "1.00x\n";
+
+    ForegroundBitmap bitmap;
+    const std::pair<ThresholdKernel, std::string> kernels[] = {
+        {ThresholdKernel::Scalar, "  bitmap scalar"},
+        {ThresholdKernel::SSE2, "  bitmap SSE2"},
+        {ThresholdKernel::AVX2, "  bitmap AVX2"},
+    };
+    for(const std::pair<ThresholdKernel, std::string> & kernel : kernels){
+        if(!ForegroundBitmap::isSupported(kernel.first)){
+            std::cout << std::left << std::setw(22) << kernel.second << "not supported on this CPU\n";
+            continue;
+        }
+        double cycles = medianCycles(repetitions, [&](){ bitmap.build(image.data(), width, height, threshold, kernel.first); });
+        std::cout << std::left << std::setw(22) << kernel.second << std::setw(14) << bytes / cycles << std::setprecision(2) << baseline / cycles << "x\n" << std::setprecision(3);
+    }
+    std::cout << "\n";
+}
+
+/**
+ * The RGB to grey conversion readPGM used before GreyConverter, three double multiplies per pixel.
+ */
+static void convertDoubles(const std::vector<unsigned char> & colour, std::vector<unsigned char> & grey){
+    for(size_t i = 0; i < grey.size(); ++i){
+        grey[i] = static_cast<unsigned char>(0.299 * colour[i*3] + 0.587 * colour[i*3 + 1] + 0.114 * colour[i*3 + 2]);
+    }
+}
+
+/**
+ * Benchmarks every RGB to grey kernel on a random colour image and prints pixels/cycle for each.
+ */
+static void benchmarkConversion(int width, int height, int repetitions){
+    std::vector<unsigned char> colour(static_cast<size_t>(width) * height * 3);
+    std::mt19937 random(42);
+    for(unsigned char & value : colour){
+        value = static_cast<unsigned char>(random() & 0xFF);
+    }
+    std::vector<unsigned char> grey(static_cast<size_t>(width) * height);
+    const double pixels = static_cast<double>(grey.size());
+
+    std::cout << "RGB to grey " << width << "x" << height << " (" << repetitions << " runs, median)\n";
+    std::cout << std::left << std::setw(22) << "  kernel" << std::setw(14) << "pixels/cycle" << "speedup\n";
+
+    double baseline = medianCycles(repetitions, [&](){ convertDoubles(colour, grey); });
+    std::cout << std::left << std::setw(22) << "  double (old)" << std::setw(14) << std::fixed << std::setprecision(3) << pixels / baseline << "1.00x\n";
+
+    const std::pair<ConversionKernel, std::string> kernels[] = {
+        {ConversionKernel::Scalar, "  fixed-point scalar"},
+        {ConversionKernel::SSSE3, "  fixed-point SSSE3"},
+    };
+    for(const std::pair<ConversionKernel, std::string> & kernel : kernels){
+        if(!GreyConverter::isSupported(kernel.first)){
+            std::cout << std::left << std::setw(22) << kernel.second << "not supported on this CPU\n";
+            continue;
+        }
+        double cycles = medianCycles(repetitions, [&](){ GreyConverter::convert(colour.data(), grey.data(), grey.size(), kernel.first); });
+        std::cout << std::left << std::setw(22) << kernel.second << std::setw(14) << pixels / cycles << std::setprecision(2) << baseline / cycles << "x\n" << std::setprecision(3);
+    }
+    std::cout << "\n";
+}
+
+/**
+ * Runs a task repetitions times and returns the median wall time of a run in milliseconds.
+ */
+static double medianMilliseconds(int repetitions, const std::function<void()> & task){
+    task();
+    std::vector<double> samples;
+    for(int i = 0; i < repetitions; ++i){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        task();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+/**
+ * Labels a random noise image with every engine at 4- and 8-connectivity and prints the time of each.
+ */
+static void benchmarkConnectivity(int width, int height, int repetitions){
+    std::string fileName = (std::filesystem::temp_directory_path() / "bench_noise.pgm").string();
+    if(!ImageGenerator::writePGM(fileName, ImageGenerator::generate(SyntheticPattern::Noise, width, height, 7), width, height)){
+        return;
+    }
+
+    PGMimageProcessor processor;
+    if(!processor.readPGM(fileName)){
+        std::filesystem::remove(fileName);
+        return;
+    }
+    std::filesystem::remove(fileName);
+
+    const unsigned char threshold = 128;
+    std::cout << "Labeling " << width << "x" << height << " noise (" << repetitions << " runs, median)\n";
+    std::cout << std::left << std::setw(22) << "  engine" << std::setw(26) << "4-connected" << "8-connected\n";
+
+    const std::pair<LabelingEngine, std::string> engines[] = {
+        {LabelingEngine::BFS, "  bfs"},
+        {LabelingEngine::UnionFind, "  unionfind"},
+        {LabelingEngine::RunLength, "  runs"},
+    };
+    for(const std::pair<LabelingEngine, std::string> & engine : engines){
+        std::cout << std::left << std::setw(22) << engine.second;
+        for(int connectivity : {4, 8}){
+            int count = 0;
+            double milliseconds = medianMilliseconds(repetitions, [&](){ count = processor.extractComponents(threshold, 1, engine.first, connectivity); });
+            std::string cell = std::to_string(static_cast<int>(milliseconds + 0.5)) + " ms (" + std::to_string(count) + ")";
+            std::cout << std::setw(26) << cell;
+        }
+        std::cout << "\n";
+    }
+    std::cout << "\n";
+}
+
+/**
+ * Median and 99th percentile of a set of timings
+ */
+struct Latency{
+    double median;
+    double p99;
+};
+
+/**
+ * Runs a task repetitions times, with setup run untimed before each run.
+ * @return the median and 99th percentile wall time of a run in milliseconds
+ */
+static Latency measure(int repetitions, const std::function<void()> & setup, const std::function<void()> & task){
+    std::vector<double> samples;
+    for(int i = 0; i < repetitions; ++i){
+        setup();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        task();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t p99 = (samples.size() * 99 + 99) / 100 - 1; //nearest-rank percentile
+    return {samples[samples.size() / 2], samples[p99]};
+}
+
+/**
+ * Prints one row of the suite table.
+ */
+static void printLatency(const std::string & phase, const Latency & latency, double megapixels){
+    std::cout << std::left << std::setw(28) << phase << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << latency.median << std::setw(12) << latency.p99
+              << std::setw(12) << std::setprecision(1) << megapixels / (latency.median / 1000.0) << "\n";
+}
+
+/**
+ * Generates one synthetic image and times every phase of findcomp on it.
+ * The raster is always copied (LoadMode::Copy) so readPGM measures decoding rather than mapping.
+ */
+static void benchmarkPhases(SyntheticPattern pattern, double megapixels, LabelingEngine engine, int threads, int repetitions){
+    int width = static_cast<int>(std::sqrt(megapixels) * 1024 + 0.5);
+    int height = static_cast<int>(megapixels * 1024 * 1024 / width + 0.5);
+    double pixels = static_cast<double>(width) * height / (1024.0 * 1024.0);
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string inputName = (directory / "bench_input.pgm").string();
+    std::string outputName = (directory / "bench_output").string();
+    if(!ImageGenerator::writePGM(inputName, ImageGenerator::generate(pattern, width, height), width, height)){
+        return;
+    }
+
+    PGMimageProcessor processor;
+    processor.setLoadMode(LoadMode::Copy);
+    processor.setThreadCount(threads);
+    const unsigned char threshold = 128;
+    const int minSize = 1, filterMin = 4, filterMax = std::numeric_limits<int>::max();
+
+    std::cout << ImageGenerator::patternName(pattern) << " " << width << "x" << height << " (" << std::fixed << std::setprecision(1)
+              << pixels << " MP, " << repetitions << " runs)\n";
+    std::cout << std::left << std::setw(28) << "  phase" << std::right << std::setw(12) << "median ms" << std::setw(12) << "p99 ms" << std::setw(12) << "MPix/s" << "\n";
+
+    auto nothing = [](){};
+    auto extract = [&](){ processor.extractComponents(threshold, minSize, engine); };
+    printLatency("  readPGM", measure(repetitions, nothing, [&](){ processor.readPGM<false>(inputName); }), pixels);
+    printLatency("  extractComponents", measure(repetitions, nothing, extract), pixels);
+    int components = processor.getComponentCount();
+    //the first query after extracting sorts the size index, later ones only search it
+    auto query = [&](){ processor.getComponentsBySize(filterMin, filterMax); };
+    printLatency("  size index sort+query", measure(repetitions, extract, query), pixels);
+    printLatency("  size index query", measure(repetitions, nothing, query), pixels);
+    //the status lines of filterComponentsBySize and writeComponents are Verbose, so nothing is printed here
+    Latency filter = measure(repetitions, extract, [&](){ processor.filterComponentsBySize(filterMin, filterMax); });
+    auto writePGM = [&](){ processor.writeComponents<bool>(outputName); };
+    auto writePPM = [&](){ processor.writeComponents<bool, false>(outputName); };
+    Latency pgm = measure(repetitions, nothing, writePGM);
+    Latency ppm = measure(repetitions, nothing, writePPM);
+    Latency boxes = measure(repetitions, nothing, [&](){ processor.writeComponents<bool, true>(outputName); });
+
+    unsigned long long before = allocationCount.load();
+    writePGM();
+    unsigned long long pgmAllocations = allocationCount.load() - before;
+    before = allocationCount.load();
+    writePPM();
+    unsigned long long ppmAllocations = allocationCount.load() - before;
+    int filtered = processor.getComponentCount();
+    printLatency("  filterComponentsBySize", filter, pixels);
+    printLatency("  writeComponents PGM", pgm, pixels);
+    printLatency("  writeComponents PPM", ppm, pixels);
+    printLatency("  writeComponents PPM+boxes", boxes, pixels);
+    std::cout << "  allocations per writeComponents: PGM " << pgmAllocations << ", PPM " << ppmAllocations << "\n";
+    std::cout << "  components: " << components << ", after filtering to >= " << filterMin << " pixels: " << filtered << "\n";
+
+    //the workspace is already sized by the runs above, so this counts what one more extraction allocates
+    before = allocationCount.load();
+    extract();
+    std::cout << "  allocations per extractComponents: " << allocationCount.load() - before << "\n\n";
+
+    std::filesystem::remove(inputName);
+    std::filesystem::remove(outputName + ".pgm");
+    std::filesystem::remove(outputName + ".ppm");
+}
+
+/**
+ * Labels frames of a synthetic video one after another with a single processor, handing each
+ * frame over with reset(), and reports the heap allocations of each frame and the peak resident memory.
+ * Four different frames are generated and then cycled through.
+ */
+static void benchmarkFrames(int frames, LabelingEngine engine, int threads){
+    const int width = 640, height = 480;
+    std::vector< std::vector<unsigned char> > video;
+    for(unsigned int seed = 1; seed <= 4; ++seed){
+        video.push_back(ImageGenerator::generate(SyntheticPattern::Blobs, width, height, seed));
+    }
+
+    PGMimageProcessor processor;
+    processor.setThreadCount(threads);
+    unsigned long long firstAllocations = 0, laterAllocations = 0;
+    long long laterComponents = 0;
+    long firstPeak = 0;
+    std::cout << "frames " << width << "x" << height << " (blobs, " << frames << " frames)\n";
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int frame = 0; frame < frames; ++frame){
+        unsigned long long before = allocationCount.load();
+        processor.reset(video[frame % video.size()], width, height);
+        processor.extractComponents(128, 1, engine);
+        unsigned long long allocations = allocationCount.load() - before;
+
+        if(frame < static_cast<int>(video.size())){
+            //the first frames size the workspace
+            firstAllocations += allocations;
+            firstPeak = ProcessingStats::getPeakMemoryKiB();
+        }else{
+            laterAllocations += allocations;
+            laterComponents += processor.getComponentCount();
+        }
+    }
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    int firstFrames = std::min(frames, static_cast<int>(video.size()));
+    int laterFrames = frames - firstFrames;
+    std::cout << std::fixed << std::setprecision(1)
+              << "  allocations per frame, first " << firstFrames << " frames: " << static_cast<double>(firstAllocations) / std::max(1, firstFrames) << "\n";
+    if(laterFrames > 0){
+        std::cout << "  allocations per frame, later frames: " << static_cast<double>(laterAllocations) / laterFrames
+                  << " (components per frame: " << static_cast<double>(laterComponents) / laterFrames << ")\n";
+    }
+    std::cout << "  peak RSS after " << firstFrames << " frames: " << firstPeak << " KiB, after " << frames << " frames: " << ProcessingStats::getPeakMemoryKiB() << " KiB\n"
+              << std::setprecision(3) << "  ms per frame: " << milliseconds / std::max(1, frames) << "\n\n";
+}
+
+/**
+ * Splits a comma separated list.
+ */
+static std::vector<std::string> splitList(const std::string & list){
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while(std::getline(stream, item, ',')){
+        items.push_back(item);
+    }
+    return items;
+}
+
+int main(int argc, char* argv[]){
+    std::vector<double> sizes = {1, 4, 16};
+    std::vector<SyntheticPattern> patterns = {SyntheticPattern::Noise, SyntheticPattern::Blobs, SyntheticPattern::Spiral, SyntheticPattern::Checkerboard};
+    LabelingEngine engine = LabelingEngine::BFS;
+    int threads = 1, repetitions = 7;
+    bool kernels = false;
+    int frames = 0;
+
+    for(int i = 1; i < argc; ++i){
+        std::string option = argv[i];
+        if(option == "--sizes" && i + 1 < argc){
+            sizes.clear();
+            for(const std::string & size : splitList(argv[++i])){
+                sizes.push_back(std::stod(size));
+                if(sizes.back() < 1 || sizes.back() > 256){
+                    std::cerr << "Sizes must be between 1 and 256 megapixels" << "\n";
+                    return 1;
+                }
+            }
+        }else if(option == "--patterns" && i + 1 < argc){
+            patterns.clear();
+            for(const std::string & name : splitList(argv[++i])){
+                SyntheticPattern pattern;
+                if(!ImageGenerator::parsePattern(name, pattern)){
+                    std::cerr << "Unknown pattern: " << name << "\n";
+                    return 1;
+                }
+                patterns.push_back(pattern);
+            }
+        }else if(option == "--engine" && i + 1 < argc){
+            std::string engineName = argv[++i];
+            if(engineName == "bfs"){
+                engine = LabelingEngine::BFS;
+            }else if(engineName == "unionfind"){
+                engine = LabelingEngine::UnionFind;
+            }else if(engineName == "runs"){
+                engine = LabelingEngine::RunLength;
+            }else{
+                std::cerr << "Unknown labeling engine: " << engineName << "\n";
+                return 1;
+            }
+        }else if(option == "--threads" && i + 1 < argc){
+            threads = std::stoi(argv[++i]);
+        }else if(option == "--reps" && i + 1 < argc){
+            repetitions = std::max(1, std::stoi(argv[++i]));
+        }else if(option == "--kernels"){
+            kernels = true;
+        }else if(option == "--frames" && i + 1 < argc){
+            frames = std::max(0, std::stoi(argv[++i]));
+        }else{
+            std::cerr << "Usage: bench [--sizes 1,4,16] [--patterns noise,blobs,spiral,checkerboard] [--engine bfs|unionfind|runs] [--threads N] [--reps N] [--kernels] [--frames N]" << "\n";
+            return 1;
+        }
+    }
+
+    if(kernels){
+        benchmarkThreshold(1024, 1024, 21); //fits in the last level cache
+        benchmarkThreshold(4096, 4096, 21);
+        benchmarkConversion(2048, 2048, 11);
+        benchmarkConnectivity(2048, 2048, 5);
+    }
+    if(frames > 0){
+        benchmarkFrames(frames, engine, threads);
+    }
+    for(double size : sizes){
+        for(SyntheticPattern pattern : patterns){
+            benchmarkPhases(pattern, size, engine, threads, repetitions);
+        }
+    }
+    return 0;
+}
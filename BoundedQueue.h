@@ -0,0 +1,85 @@
+#ifndef _BOUNDEDQUEUE_H
+#define _BOUNDEDQUEUE_H
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+/**
+ * BoundedQueue class
+ *
+ * Blocking first-in first-out queue with a fixed capacity, used to pass work between the
+ * threads of a pipeline. push waits while the queue is full, so a fast producer is held back
+ * instead of piling up work, and pop waits while it is empty. Once the queue is closed,
+ * pop drains the remaining items and then returns false.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+template <typename T> class BoundedQueue{
+    private:
+        std::deque<T> items;
+        size_t capacity; //most items the queue holds at once
+        bool closed = false; //true once no more items will be pushed
+        std::mutex mutex;
+        std::condition_variable notFull, notEmpty;
+
+    public:
+        /**
+         * Constructor
+         * @param capacity the most items the queue holds at once (at least 1)
+         */
+        BoundedQueue(size_t capacity): capacity(capacity > 0 ? capacity : 1){}
+
+        /**
+         * Adds an item, waiting while the queue is full
+         * @return false if the queue was closed and the item was not added
+         */
+        bool push(T item){
+            std::unique_lock<std::mutex> lock(mutex);
+            notFull.wait(lock, [this](){ return closed || items.size() < capacity; });
+            if(closed){
+                return false;
+            }
+            items.push_back(std::move(item));
+            notEmpty.notify_one();
+            return true;
+        }
+
+        /**
+         * Removes the oldest item, waiting while the queue is empty
+         * @return false if the queue is closed and empty
+         */
+        bool pop(T & item){
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this](){ return closed || !items.empty(); });
+            if(items.empty()){
+                return false;
+            }
+            item = std::move(items.front());
+            items.pop_front();
+            notFull.notify_one();
+            return true;
+        }
+
+        /**
+         * Closes the queue, waking every thread waiting on it
+         */
+        void close(){
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            notFull.notify_all();
+            notEmpty.notify_all();
+        }
+
+        /**
+         * @return the number of items in the queue
+         */
+        size_t size(){
+            std::lock_guard<std::mutex> lock(mutex);
+            return items.size();
+        }
+};
+
+#endif
@@ -0,0 +1,120 @@
+/**
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "ComponentArena.h"
+#include <new>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * Frees every block. The lists allocated from the arena must already be destroyed.
+ */
+ComponentArena::~ComponentArena(){
+    release();
+}
+
+/**
+ * Adds a block that can hold at least bytes bytes at the given alignment,
+ * twice as large as the last one so the number of blocks stays logarithmic.
+ *
+ * @param bytes The size of the allocation that did not fit.
+ * @param alignment The alignment of that allocation.
+ */
+void ComponentArena::addBlock(size_t bytes, size_t alignment){
+    size_t size = blocks.empty() ? initialBlockSize : blocks.back().size * 2;
+    size = std::max(size, bytes + alignment);
+    blocks.push_back({static_cast<std::byte *>(::operator new(size)), size});
+    used = 0;
+}
+
+/**
+ * Hands out the next bytes of the last block, starting a new block when they do not fit.
+ *
+ * @param bytes The size of the allocation.
+ * @param alignment The alignment of the allocation (a power of two).
+ * @return A pointer to the memory.
+ */
+void * ComponentArena::do_allocate(size_t bytes, size_t alignment){
+    if(!blocks.empty()){
+        //align the address rather than the offset, since a block is only aligned for ordinary types
+        Block & block = blocks.back();
+        size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(block.data + used) % alignment) % alignment;
+        if(used + padding + bytes <= block.size){
+            void * memory = block.data + used + padding;
+            used += padding + bytes;
+            allocated += padding + bytes;
+            return memory;
+        }
+    }
+    addBlock(bytes, alignment); //always large enough, so this recurses once
+    return do_allocate(bytes, alignment);
+}
+
+/**
+ * Does nothing - the memory is given back by reset().
+ */
+void ComponentArena::do_deallocate(void *, size_t, size_t){}
+
+/**
+ * @return true only for this arena, memory from one arena cannot be given back to another
+ */
+bool ComponentArena::do_is_equal(const std::pmr::memory_resource & other) const noexcept{
+    return this == &other;
+}
+
+/**
+ * Gives back every allocation at once. If more than one block was needed,
+ * they are replaced by one block of their combined size.
+ */
+void ComponentArena::reset(){
+    if(blocks.size() > 1){
+        size_t total = 0;
+        for(const Block & block : blocks){
+            total += block.size;
+        }
+        release();
+        blocks.push_back({static_cast<std::byte *>(::operator new(total)), total});
+    }
+    used = 0;
+    allocated = 0;
+}
+
+/**
+ * Frees every block.
+ */
+void ComponentArena::release(){
+    for(const Block & block : blocks){
+        ::operator delete(block.data);
+    }
+    blocks.clear();
+    used = 0;
+    allocated = 0;
+}
+
+/**
+ * @return the bytes handed out since the last reset
+ */
+size_t ComponentArena::getAllocated() const{
+    return allocated;
+}
+
+/**
+ * @return the bytes held in blocks
+ */
+size_t ComponentArena::getCapacity() const{
+    size_t capacity = 0;
+    for(const Block & block : blocks){
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+/**
+ * @return the number of blocks held
+ */
+size_t ComponentArena::getBlockCount() const{
+    return blocks.size();
+}
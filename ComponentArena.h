@@ -0,0 +1,83 @@
+#ifndef _COMPONENTARENA_H
+#define _COMPONENTARENA_H
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+
+/**
+ * ComponentArena class
+ *
+ * Bump allocator (a std::pmr::memory_resource) that the components of one extraction take their
+ * pixel and run lists from. An allocation moves a pointer along the current block, deallocation
+ * does nothing, and everything is given back at once by reset() when the components are cleared,
+ * so neither building nor destroying the components calls the heap per component.
+ *
+ * When an extraction needs more than one block, reset() replaces them with a single block
+ * as large as all of them together. Every later extraction that needs no more memory then
+ * allocates nothing at all, and the arena is freed with a single delete.
+ *
+ * Not thread safe - only the thread that runs extractComponents allocates from it.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+class ComponentArena : public std::pmr::memory_resource{
+    private:
+        struct Block{
+            std::byte * data;
+            size_t size;
+        };
+        std::vector<Block> blocks; //blocks in the order they were allocated, the last one is being filled
+        size_t used = 0; //bytes handed out from the last block
+        size_t allocated = 0; //bytes handed out since the last reset, including alignment padding
+
+        /**
+         * Adds a block that can hold at least bytes bytes at the given alignment
+         */
+        void addBlock(size_t bytes, size_t alignment);
+
+    protected:
+        void * do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void * memory, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override;
+
+    public:
+        //size of the first block
+        static constexpr size_t initialBlockSize = 64 * 1024;
+
+        ComponentArena() = default;
+        ~ComponentArena();
+
+        //the lists allocated from an arena point into it, so it is neither copied nor moved
+        ComponentArena(const ComponentArena &) = delete;
+        ComponentArena & operator=(const ComponentArena &) = delete;
+
+        /**
+         * Gives back every allocation at once, keeping one block as large as everything allocated so far.
+         * Nothing allocated from the arena may be used afterwards.
+         */
+        void reset();
+
+        /**
+         * Frees every block
+         */
+        void release();
+
+        /**
+         * @return the bytes handed out since the last reset
+         */
+        size_t getAllocated() const;
+
+        /**
+         * @return the bytes held in blocks
+         */
+        size_t getCapacity() const;
+
+        /**
+         * @return the number of blocks held
+         */
+        size_t getBlockCount() const;
+};
+
+#endif
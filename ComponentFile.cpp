@@ -0,0 +1,334 @@
+/**
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "ComponentFile.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <type_traits>
+
+//the sections are written and mapped as they are laid out in memory
+static_assert(sizeof(ComponentFile::Header) == 64 && std::is_trivially_copyable_v<ComponentFile::Header>);
+static_assert(sizeof(ComponentFile::Record) == 56 && std::is_trivially_copyable_v<ComponentFile::Record>);
+static_assert(sizeof(ConnectedComponent::Run) == 12 && std::is_trivially_copyable_v<ConnectedComponent::Run>);
+
+/**
+ * @return offset rounded up to a multiple of 8
+ */
+static uint64_t alignTo8(uint64_t offset){
+    return (offset + 7) & ~uint64_t(7);
+}
+
+/**
+ * @return true if a run comes before another in raster order
+ */
+static bool runBefore(const ConnectedComponent::Run & a, const ConnectedComponent::Run & b){
+    return a.y < b.y || (a.y == b.y && a.xStart < b.xStart);
+}
+
+/**
+ * Turns the pixels of a component into runs in raster order. A list that is not already in raster
+ * order (a Breadth First Search) is sorted in scratch first.
+ *
+ * @param pixels The (x, y) pixels of the component.
+ * @param scratch Reused storage for the sorted pixels.
+ * @param runs Filled with the runs.
+ */
+static void pixelsToRuns(const ConnectedComponent::PixelList & pixels, std::vector< std::pair<int, int> > & scratch, std::vector<ConnectedComponent::Run> & runs){
+    auto rasterOrder = [](const std::pair<int, int> & a, const std::pair<int, int> & b){
+        return a.second < b.second || (a.second == b.second && a.first < b.first);
+    };
+    std::span<const std::pair<int, int> > ordered(pixels);
+    if(!std::is_sorted(pixels.begin(), pixels.end(), rasterOrder)){
+        scratch.assign(pixels.begin(), pixels.end());
+        std::sort(scratch.begin(), scratch.end(), rasterOrder);
+        ordered = scratch;
+    }
+
+    runs.clear();
+    for(const std::pair<int, int> & pixel : ordered){
+        if(!runs.empty() && runs.back().y == pixel.second && runs.back().xEnd + 1 == pixel.first){
+            runs.back().xEnd = pixel.first;
+        }else{
+            runs.push_back({pixel.second, pixel.first, pixel.first});
+        }
+    }
+}
+
+/**
+ * Writes components to a .ccx file. The runs are written first, after room for the header, the record
+ * table and the size index, so each component's runs are only built once; the header, the table and the
+ * size index are filled in at the end. Run-length components are written from their runs as they are.
+ *
+ * @param fileName The name of the file, with its extension.
+ * @param components The components to write, in any order.
+ * @param width The width of the image the components were found in.
+ * @param height The height of the image the components were found in.
+ * @return True if the file was written, false otherwise.
+ */
+bool ComponentFile::write(const std::string & fileName, std::span<const ConnectedComponent> components, int width, int height){
+    std::ofstream out(fileName, std::ios::binary);
+    if(!out){
+        std::cerr << "Error: Unable to write file " << fileName << "\n";
+        return false;
+    }
+
+    //the records are in ID order, which is the order the components are normally kept in
+    std::vector<uint32_t> byID(components.size());
+    std::iota(byID.begin(), byID.end(), 0);
+    auto idOf = [&](uint32_t position){ return components[position].getID(); };
+    if(!std::ranges::is_sorted(byID, {}, idOf)){
+        std::ranges::stable_sort(byID, {}, idOf);
+    }
+
+    Header fileHeader = {};
+    std::memcpy(fileHeader.magic, magic, sizeof(magic));
+    fileHeader.version = formatVersion;
+    fileHeader.width = width;
+    fileHeader.height = height;
+    fileHeader.componentCount = components.size();
+    fileHeader.recordSize = sizeof(Record);
+    fileHeader.recordOffset = sizeof(Header);
+    fileHeader.sizeOrderOffset = fileHeader.recordOffset + components.size() * sizeof(Record);
+    fileHeader.runOffset = alignTo8(fileHeader.sizeOrderOffset + components.size() * sizeof(uint32_t));
+
+    //room for everything before the runs
+    std::vector<char> zeros(fileHeader.runOffset, 0);
+    out.write(zeros.data(), zeros.size());
+
+    std::vector<Record> table(components.size());
+    std::vector<ConnectedComponent::Run> runs;
+    std::vector< std::pair<int, int> > scratch;
+    for(size_t i = 0; i < byID.size() && out; ++i){
+        const ConnectedComponent & component = components[byID[i]];
+        std::span<const ConnectedComponent::Run> componentRuns;
+        if(component.isRunLength() && std::is_sorted(component.getRuns().begin(), component.getRuns().end(), runBefore)){
+            componentRuns = component.getRuns();
+        }else if(component.isRunLength()){
+            runs.assign(component.getRuns().begin(), component.getRuns().end());
+            std::sort(runs.begin(), runs.end(), runBefore);
+            componentRuns = runs;
+        }else{
+            pixelsToRuns(component.getPixels(), scratch, runs);
+            componentRuns = runs;
+        }
+        out.write(reinterpret_cast<const char *>(componentRuns.data()), componentRuns.size_bytes());
+
+        auto [centroidX, centroidY] = component.getCentroid();
+        Record & record = table[i];
+        record.id = component.getID();
+        record.size = component.getSize();
+        record.xMin = component.getXMin();
+        record.yMin = component.getYMin();
+        record.xMax = component.getXMax();
+        record.yMax = component.getYMax();
+        record.centroidX = centroidX;
+        record.centroidY = centroidY;
+        record.firstRun = fileHeader.runCount;
+        record.runCount = componentRuns.size();
+        fileHeader.runCount += componentRuns.size();
+    }
+    fileHeader.fileSize = fileHeader.runOffset + fileHeader.runCount * sizeof(ConnectedComponent::Run);
+
+    //largest first, and the table is in ID order, so components of the same size stay in ID order
+    std::vector<uint32_t> bySize(table.size());
+    std::iota(bySize.begin(), bySize.end(), 0);
+    std::ranges::stable_sort(bySize, std::greater<uint32_t>(), [&](uint32_t position){ return table[position].size; });
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&fileHeader), sizeof(Header));
+    out.write(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(Record));
+    out.write(reinterpret_cast<const char *>(bySize.data()), bySize.size() * sizeof(uint32_t));
+    out.close();
+    if(out.fail()){
+        std::cerr << "Error writing component file: " << fileName << "\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Move constructor - takes over the mapping and leaves the other file closed.
+ *
+ * @param componentFile The file to move from.
+ */
+ComponentFile::ComponentFile(ComponentFile && componentFile):
+    file(std::move(componentFile.file)),
+    header(componentFile.header),
+    records(componentFile.records),
+    sizeOrder(componentFile.sizeOrder),
+    runs(componentFile.runs)
+{
+    componentFile.header = nullptr;
+    componentFile.records = nullptr;
+    componentFile.sizeOrder = nullptr;
+    componentFile.runs = nullptr;
+}
+
+/**
+ * Move Assignment Operator - closes this file, then takes over the other one's mapping.
+ *
+ * @param componentFile The file to move from.
+ * @return A reference to this file.
+ */
+ComponentFile & ComponentFile::operator=(ComponentFile && componentFile){
+    if(this != &componentFile){
+        file = std::move(componentFile.file);
+        header = componentFile.header;
+        records = componentFile.records;
+        sizeOrder = componentFile.sizeOrder;
+        runs = componentFile.runs;
+        componentFile.header = nullptr;
+        componentFile.records = nullptr;
+        componentFile.sizeOrder = nullptr;
+        componentFile.runs = nullptr;
+    }
+    return *this;
+}
+
+/**
+ * Maps a .ccx file and checks that its header describes sections that lie inside the file.
+ * Nothing past the header is read, so this costs the same for any number of components.
+ *
+ * @param fileName The name of the file, with its extension.
+ * @return True if the file is open, false if it cannot be mapped or is not a valid .ccx file.
+ */
+bool ComponentFile::open(const std::string & fileName){
+    close();
+    if(!file.open(fileName)){
+        std::cerr << "Failed to open file for read: " << fileName << "\n";
+        return false;
+    }
+
+    const Header * fileHeader = reinterpret_cast<const Header *>(file.data());
+    size_t fileSize = file.size();
+    bool valid = fileSize >= sizeof(Header)
+        && std::memcmp(fileHeader->magic, magic, sizeof(magic)) == 0
+        && fileHeader->version == formatVersion
+        && fileHeader->recordSize == sizeof(Record)
+        && fileHeader->fileSize == fileSize
+        && fileHeader->recordOffset % 8 == 0 && fileHeader->recordOffset <= fileSize
+        && fileHeader->componentCount <= (fileSize - fileHeader->recordOffset) / sizeof(Record)
+        && fileHeader->sizeOrderOffset % 4 == 0 && fileHeader->sizeOrderOffset <= fileSize
+        && fileHeader->componentCount <= (fileSize - fileHeader->sizeOrderOffset) / sizeof(uint32_t)
+        && fileHeader->runOffset % 4 == 0 && fileHeader->runOffset <= fileSize
+        && fileHeader->runCount <= (fileSize - fileHeader->runOffset) / sizeof(ConnectedComponent::Run);
+    if(!valid){
+        std::cerr << "Invalid component file: " << fileName << "\n";
+        close();
+        return false;
+    }
+
+    header = fileHeader;
+    records = reinterpret_cast<const Record *>(file.data() + header->recordOffset);
+    sizeOrder = reinterpret_cast<const uint32_t *>(file.data() + header->sizeOrderOffset);
+    runs = reinterpret_cast<const ConnectedComponent::Run *>(file.data() + header->runOffset);
+    return true;
+}
+
+/**
+ * Unmaps the file.
+ */
+void ComponentFile::close(){
+    file.close();
+    header = nullptr;
+    records = nullptr;
+    sizeOrder = nullptr;
+    runs = nullptr;
+}
+
+/**
+ * @return True if a file is open.
+ */
+bool ComponentFile::isOpen() const{
+    return header != nullptr;
+}
+
+/**
+ * @return The width of the image the components were found in, 0 if no file is open.
+ */
+int ComponentFile::getWidth() const{
+    return header ? header->width : 0;
+}
+
+/**
+ * @return The height of the image the components were found in, 0 if no file is open.
+ */
+int ComponentFile::getHeight() const{
+    return header ? header->height : 0;
+}
+
+/**
+ * @return The number of components in the file, 0 if no file is open.
+ */
+size_t ComponentFile::getComponentCount() const{
+    return header ? header->componentCount : 0;
+}
+
+/**
+ * @return A view of the record table, in ID order.
+ */
+std::span<const ComponentFile::Record> ComponentFile::getRecords() const{
+    return std::span<const Record>(records, getComponentCount());
+}
+
+/**
+ * Finds a component by its ID with a binary search over the record table.
+ *
+ * @param id The ID of the component.
+ * @return The component's record, or nullptr if the file has no component with that ID.
+ */
+const ComponentFile::Record * ComponentFile::findByID(int id) const{
+    std::span<const Record> table = getRecords();
+    auto record = std::ranges::lower_bound(table, static_cast<long long>(id), {}, [](const Record & r){ return static_cast<long long>(r.id); });
+    if(record == table.end() || record->id != static_cast<uint32_t>(id) || id < 0){
+        return nullptr;
+    }
+    return &*record;
+}
+
+/**
+ * @return The positions of the records in the table, from the largest component to the smallest.
+ */
+std::span<const uint32_t> ComponentFile::getSizeOrder() const{
+    return std::span<const uint32_t>(sizeOrder, getComponentCount());
+}
+
+/**
+ * Finds the components within a size range with two binary searches over the size index.
+ *
+ * @param minSize Minimum number of pixels a component should have.
+ * @param maxSize Maximum number of pixels a component should have.
+ * @return The positions in getRecords() of the components of [minSize, maxSize] pixels, from largest to smallest.
+ */
+std::span<const uint32_t> ComponentFile::getSizeRange(int minSize, int maxSize) const{
+    std::span<const uint32_t> order = getSizeOrder();
+    if(minSize > maxSize){
+        return order.subspan(0, 0);
+    }
+    //a position outside the table (a damaged file) reads as size 0 rather than past the table
+    auto sizeOf = [this](uint32_t position){
+        return position < getComponentCount() ? static_cast<long long>(records[position].size) : 0LL;
+    };
+    auto first = std::ranges::lower_bound(order, static_cast<long long>(maxSize), std::greater<long long>(), sizeOf);
+    auto last = std::ranges::upper_bound(order, static_cast<long long>(minSize), std::greater<long long>(), sizeOf);
+    return std::span<const uint32_t>(first, std::max(first, last));
+}
+
+/**
+ * Gets the runs of a component straight from the mapped payload.
+ *
+ * @param record A record of this file.
+ * @return The runs of the component in raster order, or an empty span if the record points outside the payload.
+ */
+std::span<const ConnectedComponent::Run> ComponentFile::getRuns(const Record & record) const{
+    if(!header || record.firstRun > header->runCount || record.runCount > header->runCount - record.firstRun){
+        return {};
+    }
+    return std::span<const ConnectedComponent::Run>(runs + record.firstRun, record.runCount);
+}
@@ -0,0 +1,157 @@
+#ifndef _COMPONENTFILE_H
+#define _COMPONENTFILE_H
+#include "ConnectedComponent.h"
+#include "MappedFile.h"
+#include <span>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * ComponentFile class
+ *
+ * Binary export of a set of components (a .ccx file) that can be queried in place once memory mapped.
+ * The file holds, in order:
+ *
+ * - a Header of 64 bytes,
+ * - a table of one fixed-size Record per component (ID, size, bounding box, centroid and the position of
+ *   its runs), in ID order,
+ * - the size index: the position of each record in the table, from the largest component to the smallest
+ *   (components of the same size in ID order), as 32-bit integers,
+ * - the payload: the horizontal runs of every component, one ConnectedComponent::Run (three 32-bit integers)
+ *   per run, each component's runs together and in raster order.
+ *
+ * Every section starts on an 8 byte boundary, so once the file is mapped the records, the size index and the
+ * runs are read where they lie, without parsing or copying. open() only checks the header, so opening a file
+ * costs the same whatever the number of components, and only the pages that are used are read from disk.
+ * Numbers are stored in the byte order of the machine that wrote them (little-endian on x86 and ARM);
+ * a file written in the other order fails the version check.
+ *
+ * Once opened, a ComponentFile can be moved but not copied. The spans and pointers it returns are valid
+ * until it is closed or destroyed.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+class ComponentFile{
+    public:
+        /**
+         * The first 64 bytes of a .ccx file. The offsets are in bytes from the start of the file.
+         */
+        struct Header{
+            char magic[4]; //"CCX" and a 0
+            uint32_t version; //formatVersion
+            uint32_t width, height; //dimensions of the image the components were found in
+            uint32_t componentCount; //number of records
+            uint32_t recordSize; //sizeof(Record)
+            uint64_t recordOffset; //start of the record table
+            uint64_t sizeOrderOffset; //start of the size index
+            uint64_t runOffset; //start of the runs
+            uint64_t runCount; //total number of runs
+            uint64_t fileSize; //size of the whole file
+        };
+
+        /**
+         * One component of the record table
+         */
+        struct Record{
+            uint32_t id; //ID of the component
+            uint32_t size; //number of pixels
+            int32_t xMin, yMin, xMax, yMax; //bounding box (inclusive)
+            double centroidX, centroidY; //mean x and y of the pixels
+            uint64_t firstRun; //index of the component's first run in the payload
+            uint32_t runCount; //number of runs of the component
+            uint32_t reserved; //0, keeps the records 8 byte aligned
+        };
+
+        static constexpr char magic[4] = {'C', 'C', 'X', '\0'};
+        static constexpr uint32_t formatVersion = 1;
+
+    private:
+        MappedFile file; //the mapped .ccx file, nothing mapped if none is open
+        const Header * header = nullptr; //header of the open file
+        const Record * records = nullptr; //record table of the open file
+        const uint32_t * sizeOrder = nullptr; //size index of the open file
+        const ConnectedComponent::Run * runs = nullptr; //payload of the open file
+
+    public:
+        /**
+         * Default constructor - no file open
+         */
+        ComponentFile() = default;
+
+        ComponentFile(const ComponentFile & componentFile) = delete;
+        ComponentFile & operator=(const ComponentFile & componentFile) = delete;
+
+        /**
+         * Move constructor - the mapping is handed over, so the records stay where they are
+         */
+        ComponentFile(ComponentFile && componentFile);
+
+        /**
+         * Move Assignment Operator
+         */
+        ComponentFile & operator=(ComponentFile && componentFile);
+
+        /**
+         * Writes components (in any order) found in an image of the given size to a .ccx file.
+         * Components stored as pixel lists are written as runs.
+         * @return false if the file cannot be written
+         */
+        static bool write(const std::string & fileName, std::span<const ConnectedComponent> components, int width, int height);
+
+        /**
+         * Maps a .ccx file and checks its header, closing any file that was open before
+         * @return false if the file cannot be mapped or is not a .ccx file of this version
+         */
+        bool open(const std::string & fileName);
+
+        /**
+         * Unmaps the file
+         */
+        void close();
+
+        /**
+         * @return true if a file is open
+         */
+        bool isOpen() const;
+
+        /**
+         * @return the dimensions of the image the components were found in (0 if no file is open)
+         */
+        int getWidth() const;
+        int getHeight() const;
+
+        /**
+         * @return the number of components in the file
+         */
+        size_t getComponentCount() const;
+
+        /**
+         * @return every record, in ID order
+         */
+        std::span<const Record> getRecords() const;
+
+        /**
+         * @return the record of the component with this ID (binary search over the table), or nullptr if there is none
+         */
+        const Record * findByID(int id) const;
+
+        /**
+         * @return the positions in getRecords() of every record, from the largest component to the smallest
+         */
+        std::span<const uint32_t> getSizeOrder() const;
+
+        /**
+         * @return the positions in getRecords() of the components of minSize to maxSize pixels, from largest to smallest
+         */
+        std::span<const uint32_t> getSizeRange(int minSize, int maxSize) const;
+
+        /**
+         * @return the runs of a record of this file, in raster order (empty if they lie outside the file)
+         */
+        std::span<const ConnectedComponent::Run> getRuns(const Record & record) const;
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include "ConnectedComponent.h"
 #include <limits>
+#include <cmath>
+#include <iomanip>
 
 /**
  * Parameterized constructor with a given ID
@@ -27,7 +29,7 @@ ConnectedComponent::ConnectedComponent(int Id):
  */
 ConnectedComponent::ConnectedComponent(int id, std::vector<std::pair<int, int>> pixels) 
         : id(id), 
-        pixels(std::move(pixels)),
+        pixels(pixels.begin(), pixels.end()),
         numPixels(pixels.size()),
         x_min(std::numeric_limits<int>::max()),
         y_min(std::numeric_limits<int>::max()),
@@ -36,12 +38,91 @@ ConnectedComponent::ConnectedComponent(int id, std::vector<std::pair<int, int>>
         {
             for (const std::pair<int, int> & pixel : this->pixels) {
                 updateBounding(pixel.first, pixel.second); //update bounding for each pixel
+                statistics.addPixel(pixel.first, pixel.second);
+            }
+        }
+
+/**
+ * Parameterized Constructor
+ * initialized with a list of horizontal runs.
+ * Sets numPixels, and computes bounding box from the two ends of each run.
+ */
+ConnectedComponent::ConnectedComponent(int id, std::vector<Run> runs)
+        : id(id),
+        numPixels(0),
+        runs(runs.begin(), runs.end()),
+        x_min(std::numeric_limits<int>::max()),
+        y_min(std::numeric_limits<int>::max()),
+        x_max(std::numeric_limits<int>::min()),
+        y_max(std::numeric_limits<int>::min())
+        {
+            for (const Run & run : this->runs) {
+                numPixels += run.xEnd - run.xStart + 1;
+                updateBounding(run.xStart, run.y);
+                updateBounding(run.xEnd, run.y);
+                statistics.addRun(run.y, run.xStart, run.xEnd);
+            }
+        }
+
+/**
+ * Parameterized Constructor
+ * initialized with a list of pixels and the sums the labeling engine accumulated over them,
+ * so the moments are not summed again. The list is moved in with its allocator, so a list in an arena stays there.
+ */
+ConnectedComponent::ConnectedComponent(int id, PixelList pixels, const Statistics & statistics)
+        : id(id),
+        numPixels(static_cast<int>(pixels.size())), //counted before the list is moved
+        pixels(std::move(pixels)),
+        x_min(std::numeric_limits<int>::max()),
+        y_min(std::numeric_limits<int>::max()),
+        x_max(std::numeric_limits<int>::min()),
+        y_max(std::numeric_limits<int>::min()),
+        statistics(statistics)
+        {
+            for (const std::pair<int, int> & pixel : this->pixels) {
+                updateBounding(pixel.first, pixel.second);
             }
         }
 
+/**
+ * Parameterized Constructor
+ * initialized with a list of horizontal runs and the sums the labeling engine accumulated over them.
+ * The list is moved in with its allocator, and the pixels expanded from it later go on the default heap.
+ */
+ConnectedComponent::ConnectedComponent(int id, RunList runs, const Statistics & statistics)
+        : id(id),
+        numPixels(0),
+        runs(std::move(runs)),
+        x_min(std::numeric_limits<int>::max()),
+        y_min(std::numeric_limits<int>::max()),
+        x_max(std::numeric_limits<int>::min()),
+        y_max(std::numeric_limits<int>::min()),
+        statistics(statistics)
+        {
+            for (const Run & run : this->runs) {
+                numPixels += run.xEnd - run.xStart + 1;
+                updateBounding(run.xStart, run.y);
+                updateBounding(run.xEnd, run.y);
+            }
+        }
+
+/**
+ * Parameterized Constructor
+ * initialized with the size, bounding box and sums of a component whose pixels were not kept,
+ * such as a component streamed by StreamingExtractor without its runs. getPixels() and getRuns() are empty.
+ */
+ConnectedComponent::ConnectedComponent(int id, int numPixels, std::tuple<int, int, int, int> boundingBox, const Statistics & statistics)
+        : id(id),
+        numPixels(numPixels),
+        statistics(statistics)
+        {
+            std::tie(x_min, y_min, x_max, y_max) = boundingBox;
+        }
+
 /**
  * Copy constructor
- * Deep copies all values from another ConnectedComponent.
+ * Deep copies all values from another ConnectedComponent. The copied lists are on the default heap,
+ * so a copy outlives the arena of the original.
  */
 ConnectedComponent::ConnectedComponent(const ConnectedComponent & component):
     id(component.id),
@@ -50,21 +131,25 @@ ConnectedComponent::ConnectedComponent(const ConnectedComponent & component):
     y_min(component.y_min),
     x_max(component.x_max),
     y_max(component.y_max),
-    pixels(component.pixels)
+    pixels(component.pixels),
+    runs(component.runs),
+    statistics(component.statistics)
 {}
 
 /**
  * Move constructor - moves values from a temporary object to this object
  * Clears the original object's values to leave it in a valid state.
  */
-ConnectedComponent::ConnectedComponent(ConnectedComponent && component):
+ConnectedComponent::ConnectedComponent(ConnectedComponent && component) noexcept:
     id(component.id),
     numPixels(component.numPixels),
     x_min(component.x_min),
     y_min(component.y_min),
     x_max(component.x_max),
     y_max(component.y_max),
-    pixels(std::move(component.pixels))
+    pixels(std::move(component.pixels)),
+    runs(std::move(component.runs)),
+    statistics(component.statistics)
     {
         component.id = 0;
         component.numPixels = 0;
@@ -72,8 +157,10 @@ ConnectedComponent::ConnectedComponent(ConnectedComponent && component):
         component.y_min = 0;
         component.x_max = 0;
         component.y_max = 0;
+        component.statistics = Statistics();
 
-        component.pixels.clear(); //explicitly clear the vector
+        component.pixels.clear(); //explicitly clear the vectors
+        component.runs.clear();
     }
 
 /**
@@ -89,6 +176,8 @@ ConnectedComponent & ConnectedComponent::operator=(const ConnectedComponent & co
         x_max = component.x_max;
         y_max = component.y_max;
         pixels = component.pixels;
+        runs = component.runs;
+        statistics = component.statistics;
     }
     return *this;
 }
@@ -97,7 +186,7 @@ ConnectedComponent & ConnectedComponent::operator=(const ConnectedComponent & co
  * Move Assignment Operator
  * transfers ownership from a temporary component.
  */
-ConnectedComponent & ConnectedComponent::operator=(ConnectedComponent && component){
+ConnectedComponent & ConnectedComponent::operator=(ConnectedComponent && component) noexcept{
     if(this!= &component) { 
         id = component.id;
         numPixels = component.numPixels;
@@ -106,6 +195,8 @@ ConnectedComponent & ConnectedComponent::operator=(ConnectedComponent && compone
         x_max = component.x_max;
         y_max = component.y_max;
         pixels = std::move(component.pixels); //move pixel data
+        runs = std::move(component.runs);
+        statistics = component.statistics;
 
         component.id = 0;
         component.numPixels = 0;
@@ -113,8 +204,10 @@ ConnectedComponent & ConnectedComponent::operator=(ConnectedComponent && compone
         component.y_min = 0;
         component.x_max = 0;
         component.y_max = 0;
+        component.statistics = Statistics();
 
         component.pixels.clear();
+        component.runs.clear();
     }
     return *this;
 }
@@ -133,16 +226,41 @@ void ConnectedComponent::updateBounding(int x, int y){
  * Method that adds a pixel to the component, increments the pixel count, and updates bounding box.
  */
 void ConnectedComponent::addPixel(int x, int y){
+    if(!runs.empty()){
+        //keep a run-length component run-length encoded
+        addRun(y, x, x);
+        return;
+    }
     pixels.push_back(std::make_pair(x, y));
     numPixels++;
     updateBounding(x, y);
+    statistics.addPixel(x, y);
+}
+
+/**
+ * Method that adds a horizontal run of pixels to the component, increments the pixel count, and updates bounding box.
+ * Any pixel list that was already expanded from the runs is dropped so it is rebuilt on the next getPixels().
+ */
+void ConnectedComponent::addRun(int y, int xStart, int xEnd){
+    if(runs.empty() && !pixels.empty()){
+        //convert an existing pixel list to runs first so both never hold different pixels
+        for (const std::pair<int, int> & pixel : pixels) {
+            runs.push_back({pixel.second, pixel.first, pixel.first});
+        }
+    }
+    runs.push_back({y, xStart, xEnd});
+    pixels.clear();
+    numPixels += xEnd - xStart + 1;
+    updateBounding(xStart, y);
+    updateBounding(xEnd, y);
+    statistics.addRun(y, xStart, xEnd);
 }
 
 /**
  * @return the number of pixels
  */
 int ConnectedComponent::getSize() const{
-    return pixels.size();
+    return numPixels;
 }
 
 /**
@@ -181,13 +299,142 @@ std::tuple<int, int, int, int> ConnectedComponent::getBoundingBox() const {
 /**
  * @return the list of pixels in the component
  */
-const std::vector< std::pair<int, int> > & ConnectedComponent::getPixels() const{
+const ConnectedComponent::PixelList & ConnectedComponent::getPixels() const{
+    if(!runs.empty() && pixels.size() != static_cast<size_t>(numPixels)){
+        //expand the runs on first use - this is a cache, so it is not safe to call concurrently for the first time
+        pixels.clear();
+        pixels.reserve(numPixels);
+        for (const Run & run : runs) {
+            for (int x = run.xStart; x <= run.xEnd; ++x) {
+                pixels.push_back(std::make_pair(x, run.y));
+            }
+        }
+    }
     return pixels;
 }
 
 /**
- * print component data - component's ID and number of pixels.
+ * @return the list of runs in the component (empty if the component stores single pixels)
+ */
+const ConnectedComponent::RunList & ConnectedComponent::getRuns() const{
+    return runs;
+}
+
+/**
+ * @return true if the component stores its pixels as horizontal runs
+ */
+bool ConnectedComponent::isRunLength() const{
+    return !runs.empty();
+}
+
+/**
+ * @return the moment and intensity sums
+ */
+const ConnectedComponent::Statistics & ConnectedComponent::getStatistics() const{
+    return statistics;
+}
+
+/**
+ * @return the mean (x, y) of the pixels, (0, 0) for an empty component
+ */
+std::pair<double, double> ConnectedComponent::getCentroid() const{
+    if(numPixels == 0){
+        return {0.0, 0.0};
+    }
+    return {static_cast<double>(statistics.sumX) / numPixels, static_cast<double>(statistics.sumY) / numPixels};
+}
+
+/**
+ * Computes the central second moments from the raw sums.
+ * N*sum(xx) - sum(x)^2 is taken in 128-bit integers so that the subtraction is exact,
+ * a double would cancel away the variance of small components far from the origin.
+ *
+ * @return (mu20, mu02, mu11) divided by the size, (0, 0, 0) for an empty component
+ */
+std::tuple<double, double, double> ConnectedComponent::getSecondMoments() const{
+    if(numPixels == 0){
+        return {0.0, 0.0, 0.0};
+    }
+    __int128 count = numPixels;
+    double squaredCount = static_cast<double>(numPixels) * numPixels;
+    double mu20 = static_cast<double>(count*statistics.sumXX - static_cast<__int128>(statistics.sumX)*statistics.sumX) / squaredCount;
+    double mu02 = static_cast<double>(count*statistics.sumYY - static_cast<__int128>(statistics.sumY)*statistics.sumY) / squaredCount;
+    double mu11 = static_cast<double>(count*statistics.sumXY - static_cast<__int128>(statistics.sumX)*statistics.sumY) / squaredCount;
+    return {mu20, mu02, mu11};
+}
+
+/**
+ * @return the angle of the major axis, 0.5 * atan2(2*mu11, mu20 - mu02)
+ */
+double ConnectedComponent::getOrientation() const{
+    auto [mu20, mu02, mu11] = getSecondMoments();
+    return 0.5 * std::atan2(2.0 * mu11, mu20 - mu02);
+}
+
+/**
+ * The eigenvalues of the covariance matrix are the squared semi-axes (up to a scale) of the ellipse with
+ * the same second moments, and the eccentricity is sqrt(1 - minor / major).
+ *
+ * @return the eccentricity in [0, 1], 0 for a single pixel
+ */
+double ConnectedComponent::getEccentricity() const{
+    auto [mu20, mu02, mu11] = getSecondMoments();
+    double mean = (mu20 + mu02) / 2.0;
+    double spread = std::sqrt((mu20 - mu02) * (mu20 - mu02) / 4.0 + mu11 * mu11);
+    double major = mean + spread, minor = mean - spread;
+    if(major <= 0){
+        return 0.0;
+    }
+    return std::sqrt(std::max(0.0, 1.0 - minor / major));
+}
+
+/**
+ * @return true if the grey levels of the original image were accumulated while labeling
+ */
+bool ConnectedComponent::hasIntensity() const{
+    return statistics.minIntensity <= statistics.maxIntensity;
+}
+
+/**
+ * @return the mean grey level of the pixels
+ */
+double ConnectedComponent::getMeanIntensity() const{
+    return (hasIntensity() && numPixels > 0) ? static_cast<double>(statistics.sumIntensity) / numPixels : 0.0;
+}
+
+/**
+ * @return the darkest grey level of the pixels
+ */
+int ConnectedComponent::getMinIntensity() const{
+    return hasIntensity() ? statistics.minIntensity : 0;
+}
+
+/**
+ * @return the brightest grey level of the pixels
+ */
+int ConnectedComponent::getMaxIntensity() const{
+    return hasIntensity() ? statistics.maxIntensity : 0;
+}
+
+/**
+ * print component data - component's ID and number of pixels,
+ * then the centroid, orientation (in degrees), eccentricity and intensity.
  */
 void ConnectedComponent::printData() const {
-    std::cout << "Component ID: " << id << ", Size: " << numPixels << " pixels." << std::endl;
+    std::pair<double, double> centroid = getCentroid();
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+
+    std::cout << "Component ID: " << id << ", Size: " << numPixels << " pixels.\n";
+    std::cout << std::fixed << std::setprecision(2)
+              << "  Centroid: (" << centroid.first << ", " << centroid.second << ")"
+              << ", Orientation: " << getOrientation() * 180.0 / M_PI << " degrees"
+              << ", Eccentricity: " << std::setprecision(3) << getEccentricity();
+    if(hasIntensity()){
+        std::cout << std::setprecision(2) << ", Intensity: mean " << getMeanIntensity() << ", min " << getMinIntensity() << ", max " << getMaxIntensity();
+    }
+    std::cout << "\n";
+
+    std::cout.flags(flags);
+    std::cout.precision(precision);
 }
\ No newline at end of file
@@ -10,23 +10,112 @@
 #include <string>
 #include <limits>
 #include <queue>
+#include <algorithm>
+#include <tuple>
+#include <memory_resource>
 
 /**
  * Represents a Connected Component in a binary image.
  *
  * A Connected Component is a group of pixels that are connected and share the same value (white(255) or black(0) in a binary image).
+ *
+ * The pixels are stored either as a list of (x, y) coordinates or as horizontal runs.
+ * A run-length component only keeps its runs, and getPixels() expands them the first time it is called.
+ * Both lists are std::pmr vectors, so the labeling engines can place them in an arena (see ComponentArena),
+ * while lists built any other way, and copies, use the default heap.
  */
 class ConnectedComponent{
+    public:
+        /**
+         * A horizontal run of pixels on row y, from xStart to xEnd (both inclusive)
+         */
+        struct Run{
+            int y;
+            int xStart;
+            int xEnd;
+        };
+
+        typedef std::pmr::vector< std::pair<int, int> > PixelList; //(x, y) coordinates of pixels
+        typedef std::pmr::vector<Run> RunList; //horizontal runs
+
+        /**
+         * Running sums over the pixels of a component, added to while the component is labeled,
+         * from which the centroid, second moments, orientation, eccentricity and intensity are derived.
+         * The coordinate sums are exact 64-bit integers (for images up to about 45000 pixels on a side).
+         * The intensity sums cover the grey levels of the original image, and are empty for
+         * components that were built without it.
+         */
+        struct Statistics{
+            long long sumX = 0, sumY = 0; //first moments
+            long long sumXX = 0, sumYY = 0, sumXY = 0; //second moments
+            unsigned long long sumIntensity = 0; //sum of the grey levels
+            int minIntensity = 256, maxIntensity = -1; //minIntensity > maxIntensity until a grey level is added
+
+            //Adds the coordinates of one pixel
+            void addPixel(int x, int y){
+                sumX += x;
+                sumY += y;
+                sumXX += static_cast<long long>(x)*x;
+                sumYY += static_cast<long long>(y)*y;
+                sumXY += static_cast<long long>(x)*y;
+            }
+
+            //Adds the coordinates of the pixels xStart to xEnd of row y in closed form
+            void addRun(int y, int xStart, int xEnd){
+                long long count = xEnd - xStart + 1;
+                long long runSumX = (static_cast<long long>(xStart) + xEnd) * count / 2;
+                //sum of x*x from xStart to xEnd, as the difference of two sums of squares from 0
+                auto squares = [](long long n){ return n < 0 ? 0 : n*(n + 1)*(2*n + 1) / 6; };
+                sumX += runSumX;
+                sumY += count * y;
+                sumXX += squares(xEnd) - squares(xStart - 1);
+                sumYY += count * y * y;
+                sumXY += runSumX * y;
+            }
+
+            //Adds the grey level of one pixel
+            void addIntensity(unsigned char value){
+                sumIntensity += value;
+                minIntensity = std::min(minIntensity, static_cast<int>(value));
+                maxIntensity = std::max(maxIntensity, static_cast<int>(value));
+            }
+
+            //Adds the grey levels of count consecutive pixels
+            void addIntensities(const unsigned char * values, int count){
+                for(int i = 0; i < count; ++i){
+                    addIntensity(values[i]);
+                }
+            }
+
+            //Adds the sums of another set of pixels
+            void merge(const Statistics & other){
+                sumX += other.sumX;
+                sumY += other.sumY;
+                sumXX += other.sumXX;
+                sumYY += other.sumYY;
+                sumXY += other.sumXY;
+                sumIntensity += other.sumIntensity;
+                minIntensity = std::min(minIntensity, other.minIntensity);
+                maxIntensity = std::max(maxIntensity, other.maxIntensity);
+            }
+        };
+
     private:
-        int id; //unique identifier for the component
-        int numPixels; //no. of pixels in the component
-        std::vector< std::pair<int, int> > pixels; //list of pixels of the component
-        int x_min, y_min, x_max, y_max; //these represent the bounding box coordinates of the Connected Component
+        int id = 0; //unique identifier for the component
+        int numPixels = 0; //no. of pixels in the component
+        mutable PixelList pixels; //list of pixels of the component (expanded on demand, on the default heap, for run-length components)
+        RunList runs; //horizontal runs of the component, empty unless the component is stored run-length encoded
+        int x_min = 0, y_min = 0, x_max = 0, y_max = 0; //these represent the bounding box coordinates of the Connected Component
+        Statistics statistics; //moment and intensity sums of the pixels
     
     public:
         //Constructors and Destructor - Big 6
         ConnectedComponent(int id); //Parameteized Constructor which initializes an empty component with a given ID
         ConnectedComponent(int id, std::vector<std::pair<int, int>> pixels); //Parameterized Constructor which initializes a component with a given ID and a list of pixels
+        ConnectedComponent(int id, std::vector<Run> runs); //Parameterized Constructor which initializes a run-length encoded component with a given ID and a list of runs
+        ConnectedComponent(int id, PixelList pixels, const Statistics & statistics); //Takes over a pixel list (and its allocator), with the sums already accumulated while labeling
+        ConnectedComponent(int id, RunList runs, const Statistics & statistics); //Takes over a run list (and its allocator), with the sums already accumulated while labeling
+        ConnectedComponent(int id, int numPixels, std::tuple<int, int, int, int> boundingBox, const Statistics & statistics); //A summary of a component (size, bounding box (x_min, y_min, x_max, y_max) and sums) that does not keep its pixels
 
         //Big 6
         //Default constructor - initialises an empty component with default values
@@ -38,19 +127,22 @@ class ConnectedComponent{
         //Copy constructor
         ConnectedComponent(const ConnectedComponent & component);
         
-        //Move constructor
-        ConnectedComponent(ConnectedComponent && component);
+        //Move constructor - noexcept so a std::vector of components moves them when it grows instead of copying them
+        ConnectedComponent(ConnectedComponent && component) noexcept;
         
         //Copy assignment operator
         ConnectedComponent & operator=(const ConnectedComponent & component);
         
         //Move assignment operator
-        ConnectedComponent & operator=(ConnectedComponent && component);
+        ConnectedComponent & operator=(ConnectedComponent && component) noexcept;
 
 
-        //Adds a pixel to a component and updates the bounding box
+        //Adds a pixel to a component and updates the bounding box and moments
         void addPixel(int x, int y);
 
+        //Adds a horizontal run of pixels to a component and updates the bounding box and moments
+        void addRun(int y, int xStart, int xEnd);
+
         //Returns the number of pixels in the component
         int getSize() const;
 
@@ -66,13 +158,42 @@ class ConnectedComponent{
         //Returns the bounding box as a tuple: (x_min, y_min, x_max, y_max)
         std::tuple<int, int, int, int> getBoundingBox() const;
         
-        //Returns a constant reference to the vector of pixels
-        const std::vector< std::pair<int, int> > & getPixels() const;
+        //Returns a constant reference to the vector of pixels (expanding the runs of a run-length component)
+        const PixelList & getPixels() const;
+
+        //Returns a constant reference to the vector of runs (empty unless the component is run-length encoded)
+        const RunList & getRuns() const;
+
+        //Returns true if the component stores its pixels as horizontal runs
+        bool isRunLength() const;
+
+        //Returns the moment and intensity sums of the component
+        const Statistics & getStatistics() const;
+
+        //Returns the centroid as (x, y)
+        std::pair<double, double> getCentroid() const;
+
+        //Returns the central second moments divided by the size: (mu20, mu02, mu11), the variance of x and y and their covariance
+        std::tuple<double, double, double> getSecondMoments() const;
+
+        //Returns the angle of the major axis in radians, from the x axis towards the y axis (down the image), in (-pi/2, pi/2]
+        double getOrientation() const;
+
+        //Returns the eccentricity of the ellipse with the same second moments, 0 for a circle and approaching 1 for a line
+        double getEccentricity() const;
+
+        //Returns true if the grey levels of the original image were accumulated
+        bool hasIntensity() const;
+
+        //Intensity getters over the grey levels of the original image (0 if hasIntensity() is false)
+        double getMeanIntensity() const;
+        int getMinIntensity() const;
+        int getMaxIntensity() const;
         
         //Updates the bounding box coordinates of the new pixel
         void updateBounding(int x, int y);
 
-        //Prints the component's ID and size
+        //Prints the component's ID and size, then its centroid, shape and intensity
         void printData() const;
 };
 
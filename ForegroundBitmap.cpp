@@ -0,0 +1,224 @@
+/**
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "ForegroundBitmap.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FOREGROUND_BITMAP_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * Scalar kernel - packs one pixel per loop iteration.
+ * Also finishes the last (width % 64) pixels of a row for the vector kernels.
+ */
+static void thresholdRowScalar(const unsigned char * pixels, int count, unsigned char threshold, uint64_t * bits){
+    for(int x = 0; x < count; x += 64){
+        int end = (count - x < 64) ? count - x : 64;
+        uint64_t word = 0;
+        for(int i = 0; i < end; ++i){
+            word |= static_cast<uint64_t>(pixels[x + i] >= threshold) << i;
+        }
+        bits[x >> 6] = word;
+    }
+}
+
+#ifdef FOREGROUND_BITMAP_X86
+/**
+ * SSE2 kernel - 16 pixels per compare.
+ * SSE2 has no unsigned byte compare, so p >= t is computed as max(p, t) == p,
+ * and movemask packs the 16 compare results straight into 16 bits.
+ */
+__attribute__((target("sse2")))
+static void thresholdRowSSE2(const unsigned char * pixels, int count, unsigned char threshold, uint64_t * bits){
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+    int fullWords = count / 64;
+    for(int w = 0; w < fullWords; ++w){
+        const unsigned char * block = pixels + w*64;
+        uint64_t word = 0;
+        for(int i = 0; i < 4; ++i){
+            __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i*16));
+            __m128i isForeground = _mm_cmpeq_epi8(_mm_max_epu8(value, limit), value);
+            word |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(isForeground))) << (i*16);
+        }
+        bits[w] = word;
+    }
+    thresholdRowScalar(pixels + fullWords*64, count - fullWords*64, threshold, bits + fullWords);
+}
+
+/**
+ * AVX2 kernel - 32 pixels per compare, using the same max/compare trick as the SSE2 kernel.
+ */
+__attribute__((target("avx2")))
+static void thresholdRowAVX2(const unsigned char * pixels, int count, unsigned char threshold, uint64_t * bits){
+    const __m256i limit = _mm256_set1_epi8(static_cast<char>(threshold));
+    int fullWords = count / 64;
+    for(int w = 0; w < fullWords; ++w){
+        const unsigned char * block = pixels + w*64;
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+        uint32_t lowBits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(low, limit), low)));
+        uint32_t highBits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(high, limit), high)));
+        bits[w] = static_cast<uint64_t>(lowBits) | (static_cast<uint64_t>(highBits) << 32);
+    }
+    thresholdRowScalar(pixels + fullWords*64, count - fullWords*64, threshold, bits + fullWords);
+}
+#endif
+
+/**
+ * Sizes the bitmap for a width x height image.
+ * std::vector::resize keeps its capacity, so a bitmap reused for same-sized images never reallocates.
+ */
+void ForegroundBitmap::resize(int width, int height){
+    this->width = width;
+    this->height = height;
+    wordsPerRow = (static_cast<size_t>(width) + 63) / 64;
+    words.resize(wordsPerRow * height);
+}
+
+/**
+ * Thresholds rows [yBegin, yEnd) of the image into the bitmap.
+ * Falls back to the scalar kernel if the requested one is not supported by this CPU.
+ *
+ * @param image The 8-bit image, width*height bytes in row order.
+ * @param threshold Pixels >= threshold are foreground.
+ * @param yBegin The first row to threshold.
+ * @param yEnd One past the last row to threshold.
+ * @param kernel The instruction set to use.
+ */
+void ForegroundBitmap::thresholdRows(const unsigned char * image, unsigned char threshold, int yBegin, int yEnd, ThresholdKernel kernel){
+    if(!isSupported(kernel)){
+        kernel = ThresholdKernel::Scalar;
+    }
+
+    for(int y = yBegin; y < yEnd; ++y){
+        const unsigned char * pixels = image + static_cast<size_t>(y)*width;
+        uint64_t * bits = words.data() + y*wordsPerRow;
+        switch(kernel){
+#ifdef FOREGROUND_BITMAP_X86
+            case ThresholdKernel::AVX2:
+                thresholdRowAVX2(pixels, width, threshold, bits);
+                break;
+            case ThresholdKernel::SSE2:
+                thresholdRowSSE2(pixels, width, threshold, bits);
+                break;
+#endif
+            default:
+                thresholdRowScalar(pixels, width, threshold, bits);
+                break;
+        }
+    }
+}
+
+/**
+ * Sizes the bitmap and thresholds every row of the image.
+ */
+void ForegroundBitmap::build(const unsigned char * image, int width, int height, unsigned char threshold, ThresholdKernel kernel){
+    resize(width, height);
+    thresholdRows(image, threshold, 0, height, kernel);
+}
+
+/**
+ * Finds the next foreground pixel on a row by skipping whole background words.
+ *
+ * @param y The row to search.
+ * @param x The first x coordinate to check.
+ * @return The x coordinate of the next foreground pixel, or width if there is none.
+ */
+int ForegroundBitmap::nextForeground(int y, int x) const{
+    if(x >= width){
+        return width;
+    }
+    const uint64_t * bits = row(y);
+    size_t w = x >> 6;
+    uint64_t word = bits[w] & (~0ULL << (x & 63)); //ignore the pixels before x
+    while(word == 0){
+        if(++w == wordsPerRow){
+            return width;
+        }
+        word = bits[w];
+    }
+    int found = static_cast<int>(w*64) + __builtin_ctzll(word);
+    return (found < width) ? found : width;
+}
+
+/**
+ * Finds the next background pixel on a row by skipping whole foreground words.
+ * The padding bits after the last pixel are always 0, so a row always ends in background.
+ *
+ * @param y The row to search.
+ * @param x The first x coordinate to check.
+ * @return The x coordinate of the next background pixel, or width if there is none.
+ */
+int ForegroundBitmap::nextBackground(int y, int x) const{
+    if(x >= width){
+        return width;
+    }
+    const uint64_t * bits = row(y);
+    size_t w = x >> 6;
+    uint64_t word = ~bits[w] & (~0ULL << (x & 63));
+    while(word == 0){
+        if(++w == wordsPerRow){
+            return width;
+        }
+        word = ~bits[w];
+    }
+    int found = static_cast<int>(w*64) + __builtin_ctzll(word);
+    return (found < width) ? found : width;
+}
+
+/**
+ * @return the number of 64-bit words per row
+ */
+size_t ForegroundBitmap::getWordsPerRow() const{
+    return wordsPerRow;
+}
+
+/**
+ * @return the width of the bitmap
+ */
+int ForegroundBitmap::getWidth() const{
+    return width;
+}
+
+/**
+ * @return the height of the bitmap
+ */
+int ForegroundBitmap::getHeight() const{
+    return height;
+}
+
+/**
+ * Checks whether a kernel can run on this CPU.
+ * SSE2 is part of every x86-64 CPU, AVX2 is checked with cpuid.
+ *
+ * @param kernel The kernel to check.
+ * @return true if the kernel is supported.
+ */
+bool ForegroundBitmap::isSupported(ThresholdKernel kernel){
+    switch(kernel){
+        case ThresholdKernel::Scalar:
+            return true;
+#ifdef FOREGROUND_BITMAP_X86
+        case ThresholdKernel::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case ThresholdKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+/**
+ * @return the widest kernel this CPU supports, checked once and then cached
+ */
+ThresholdKernel ForegroundBitmap::bestKernel(){
+    static const ThresholdKernel best = isSupported(ThresholdKernel::AVX2) ? ThresholdKernel::AVX2
+                                      : isSupported(ThresholdKernel::SSE2) ? ThresholdKernel::SSE2
+                                      : ThresholdKernel::Scalar;
+    return best;
+}
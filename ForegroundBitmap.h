@@ -0,0 +1,103 @@
+#ifndef _FOREGROUNDBITMAP_H
+#define _FOREGROUNDBITMAP_H
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Selects the instruction set used to threshold a row of pixels.
+ *
+ * Scalar - portable loop, one pixel at a time.
+ * SSE2 - compares 16 pixels per instruction (x86 only).
+ * AVX2 - compares 32 pixels per instruction (x86 only, checked at runtime).
+ */
+enum class ThresholdKernel { Scalar, SSE2, AVX2 };
+
+/**
+ * ForegroundBitmap class
+ *
+ * Packed 1-bit-per-pixel foreground mask of a thresholded image.
+ * Bit (x % 64) of word (x / 64) in row y is set when pixel (x, y) >= threshold,
+ * and every row starts on a new 64-bit word so rows can be thresholded independently.
+ * This is an eighth of the size of a byte-per-pixel binary image, and the labeling
+ * engines scan it a word at a time, skipping 64 background pixels per zero word.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+class ForegroundBitmap{
+    private:
+        int width = 0, height = 0; //dimensions of the image
+        size_t wordsPerRow = 0; //number of 64-bit words per row
+        std::vector<uint64_t> words; //the packed bits, row by row
+
+    public:
+        /**
+         * Sizes the bitmap for an image, reusing the existing storage when it is large enough.
+         * The contents are undefined until the rows are thresholded.
+         */
+        void resize(int width, int height);
+
+        /**
+         * Thresholds rows [yBegin, yEnd) of an 8-bit image into the bitmap with the given kernel.
+         * Different row ranges may be thresholded by different threads at the same time.
+         */
+        void thresholdRows(const unsigned char * image, unsigned char threshold, int yBegin, int yEnd, ThresholdKernel kernel = bestKernel());
+
+        /**
+         * Sizes the bitmap and thresholds the whole image.
+         */
+        void build(const unsigned char * image, int width, int height, unsigned char threshold, ThresholdKernel kernel = bestKernel());
+
+        /**
+         * @return true if pixel (x, y) is foreground
+         */
+        bool test(int x, int y) const{
+            return (words[y*wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+        }
+
+        /**
+         * @return a pointer to the first word of row y
+         */
+        const uint64_t * row(int y) const{
+            return words.data() + y*wordsPerRow;
+        }
+
+        /**
+         * @return the x coordinate of the first foreground pixel at or after x on row y, or width if there is none
+         */
+        int nextForeground(int y, int x) const;
+
+        /**
+         * @return the x coordinate of the first background pixel at or after x on row y, or width if there is none
+         */
+        int nextBackground(int y, int x) const;
+
+        /**
+         * @return the number of 64-bit words per row
+         */
+        size_t getWordsPerRow() const;
+
+        /**
+         * @return the width of the bitmap
+         */
+        int getWidth() const;
+
+        /**
+         * @return the height of the bitmap
+         */
+        int getHeight() const;
+
+        /**
+         * @return true if the kernel can run on this CPU
+         */
+        static bool isSupported(ThresholdKernel kernel);
+
+        /**
+         * @return the fastest kernel supported by this CPU
+         */
+        static ThresholdKernel bestKernel();
+};
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "GreyConverter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GREY_CONVERTER_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * Scalar kernel - converts one pixel per loop iteration.
+ * Also finishes the last (count % 16) pixels for the SSSE3 kernel.
+ */
+static void convertScalar(const unsigned char * rgb, unsigned char * grey, size_t count){
+    for(size_t i = 0; i < count; ++i){
+        grey[i] = GreyConverter::greyLevel(rgb[i*3], rgb[i*3 + 1], rgb[i*3 + 2]);
+    }
+}
+
+#ifdef GREY_CONVERTER_X86
+/**
+ * SSSE3 kernel - 16 pixels (48 bytes, three loads) per iteration.
+ * Each channel is gathered out of the three loads with one byte shuffle per load (bytes from
+ * other loads are zeroed) and the three results are or-ed together. The channels are then
+ * widened to 16 bits, where 77*R + 150*G + 29*B <= 65280 fits without overflow.
+ */
+__attribute__((target("ssse3")))
+static void convertSSSE3(const unsigned char * rgb, unsigned char * grey, size_t count){
+    //shuffle[channel][load] moves byte 3*p + channel of the 48 to byte p, when it lies in that load
+    __m128i shuffle[3][3];
+    for(int channel = 0; channel < 3; ++channel){
+        for(int load = 0; load < 3; ++load){
+            alignas(16) signed char mask[16];
+            for(int p = 0; p < 16; ++p){
+                int index = 3*p + channel;
+                mask[p] = (index / 16 == load) ? static_cast<signed char>(index % 16) : static_cast<signed char>(0x80);
+            }
+            shuffle[channel][load] = _mm_load_si128(reinterpret_cast<const __m128i *>(mask));
+        }
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i redWeight = _mm_set1_epi16(77), greenWeight = _mm_set1_epi16(150), blueWeight = _mm_set1_epi16(29);
+    size_t blocks = count / 16;
+    for(size_t b = 0; b < blocks; ++b){
+        const unsigned char * block = rgb + b*48;
+        __m128i loads[3] = {
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(block)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 32))
+        };
+        __m128i channels[3];
+        for(int channel = 0; channel < 3; ++channel){
+            channels[channel] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(loads[0], shuffle[channel][0]), _mm_shuffle_epi8(loads[1], shuffle[channel][1])),
+                                             _mm_shuffle_epi8(loads[2], shuffle[channel][2]));
+        }
+
+        __m128i low = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(channels[0], zero), redWeight),
+                                                  _mm_mullo_epi16(_mm_unpacklo_epi8(channels[1], zero), greenWeight)),
+                                    _mm_mullo_epi16(_mm_unpacklo_epi8(channels[2], zero), blueWeight));
+        __m128i high = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(channels[0], zero), redWeight),
+                                                   _mm_mullo_epi16(_mm_unpackhi_epi8(channels[1], zero), greenWeight)),
+                                     _mm_mullo_epi16(_mm_unpackhi_epi8(channels[2], zero), blueWeight));
+        __m128i levels = _mm_packus_epi16(_mm_srli_epi16(low, 8), _mm_srli_epi16(high, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(grey + b*16), levels);
+    }
+    convertScalar(rgb + blocks*48, grey + blocks*16, count - blocks*16);
+}
+#endif
+
+/**
+ * Converts interleaved RGB pixels to grey levels.
+ * Falls back to the scalar kernel if the requested one is not supported by this CPU.
+ *
+ * @param rgb The colour pixels, 3*count bytes.
+ * @param grey Receives the count grey levels (must not overlap rgb).
+ * @param count The number of pixels.
+ * @param kernel The instruction set to use.
+ */
+void GreyConverter::convert(const unsigned char * rgb, unsigned char * grey, size_t count, ConversionKernel kernel){
+#ifdef GREY_CONVERTER_X86
+    if(kernel == ConversionKernel::SSSE3 && isSupported(kernel)){
+        convertSSSE3(rgb, grey, count);
+        return;
+    }
+#endif
+    convertScalar(rgb, grey, count);
+}
+
+/**
+ * Checks whether a kernel can run on this CPU.
+ *
+ * @param kernel The kernel to check.
+ * @return true if the kernel is supported.
+ */
+bool GreyConverter::isSupported(ConversionKernel kernel){
+    switch(kernel){
+        case ConversionKernel::Scalar:
+            return true;
+#ifdef GREY_CONVERTER_X86
+        case ConversionKernel::SSSE3:
+            return __builtin_cpu_supports("ssse3");
+#endif
+        default:
+            return false;
+    }
+}
+
+/**
+ * @return the widest kernel this CPU supports, checked once and then cached
+ */
+ConversionKernel GreyConverter::bestKernel(){
+    static const ConversionKernel best = isSupported(ConversionKernel::SSSE3) ? ConversionKernel::SSSE3 : ConversionKernel::Scalar;
+    return best;
+}
@@ -0,0 +1,153 @@
+/**
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "ImageGenerator.h"
+#include <random>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+/**
+ * Sets a rectangle of pixels to a value, clipped to the image.
+ */
+static void fillRectangle(std::vector<unsigned char> & image, int width, int height, int x0, int y0, int x1, int y1, unsigned char value){
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, width - 1);
+    y1 = std::min(y1, height - 1);
+    for(int y = y0; y <= y1; ++y){
+        for(int x = x0; x <= x1; ++x){
+            image[static_cast<size_t>(y)*width + x] = value;
+        }
+    }
+}
+
+/**
+ * Generates a synthetic image.
+ *
+ * @param pattern The foreground pattern.
+ * @param width The width of the image.
+ * @param height The height of the image.
+ * @param seed Seed of the random patterns (noise and blobs).
+ * @return The width*height grey levels in row order.
+ */
+std::vector<unsigned char> ImageGenerator::generate(SyntheticPattern pattern, int width, int height, unsigned int seed){
+    std::vector<unsigned char> image(static_cast<size_t>(width) * height, 0);
+    std::mt19937 random(seed);
+
+    switch(pattern){
+        case SyntheticPattern::Noise:
+            for(unsigned char & pixel : image){
+                pixel = static_cast<unsigned char>(random() & 0xFF);
+            }
+            break;
+
+        case SyntheticPattern::Blobs:{
+            //dark background noise, then one disc per 20000 pixels
+            for(unsigned char & pixel : image){
+                pixel = static_cast<unsigned char>(random() & 0x3F);
+            }
+            size_t blobCount = std::max<size_t>(1, image.size() / 20000);
+            std::uniform_int_distribution<int> xPosition(0, width - 1), yPosition(0, height - 1), radiusLength(4, 24);
+            for(size_t b = 0; b < blobCount; ++b){
+                int cx = xPosition(random), cy = yPosition(random), radius = radiusLength(random);
+                for(int y = std::max(0, cy - radius); y <= std::min(height - 1, cy + radius); ++y){
+                    for(int x = std::max(0, cx - radius); x <= std::min(width - 1, cx + radius); ++x){
+                        if((x - cx)*(x - cx) + (y - cy)*(y - cy) <= radius*radius){
+                            image[static_cast<size_t>(y)*width + x] = static_cast<unsigned char>(192 + (random() & 0x3F));
+                        }
+                    }
+                }
+            }
+            break;
+        }
+
+        case SyntheticPattern::Spiral:{
+            //each lap draws the top, right, bottom and left sides of a rectangle two pixels thick,
+            //and the next lap starts four pixels further in, joined to the end of the left side
+            std::fill(image.begin(), image.end(), 50);
+            const unsigned char foreground = 200;
+            for(int lap = 0; ; ++lap){
+                int x0 = 4*lap, y0 = 4*lap;
+                int x1 = width - 2 - 4*lap, y1 = height - 2 - 4*lap;
+                if(x1 - x0 < 4 || y1 - y0 < 4){
+                    break;
+                }
+                fillRectangle(image, width, height, std::max(0, x0 - 4), y0, x1 + 1, y0 + 1, foreground); //top
+                fillRectangle(image, width, height, x1, y0, x1 + 1, y1 + 1, foreground); //right
+                fillRectangle(image, width, height, x0, y1, x1 + 1, y1 + 1, foreground); //bottom
+                fillRectangle(image, width, height, x0, y0 + 4, x0 + 1, y1 + 1, foreground); //left
+            }
+            break;
+        }
+
+        case SyntheticPattern::Checkerboard:
+            for(int y = 0; y < height; ++y){
+                for(int x = 0; x < width; ++x){
+                    image[static_cast<size_t>(y)*width + x] = ((x + y) & 1) ? 255 : 0;
+                }
+            }
+            break;
+    }
+    return image;
+}
+
+/**
+ * Writes an image to a PGM file.
+ *
+ * @param fileName The file path of the output image.
+ * @param image The width*height grey levels.
+ * @param width The width of the image.
+ * @param height The height of the image.
+ * @return true if the file is successfully written; false if otherwise.
+ */
+bool ImageGenerator::writePGM(const std::string & fileName, const std::vector<unsigned char> & image, int width, int height){
+    std::ofstream out(fileName, std::ios::binary);
+    if(!out){
+        std::cerr << "Error: Unable to write file " << fileName << "\n";
+        return false;
+    }
+    out << "P5\n" << width << " " << height << "\n255\n";
+    out.write(reinterpret_cast<const char *>(image.data()), image.size());
+    if(!out){
+        std::cerr << "Error writing binary block of PGM.\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Looks up a pattern by name.
+ *
+ * @param name noise, blobs, spiral or checkerboard.
+ * @param pattern Receives the pattern.
+ * @return true if the name is a pattern.
+ */
+bool ImageGenerator::parsePattern(const std::string & name, SyntheticPattern & pattern){
+    for(SyntheticPattern candidate : {SyntheticPattern::Noise, SyntheticPattern::Blobs, SyntheticPattern::Spiral, SyntheticPattern::Checkerboard}){
+        if(patternName(candidate) == name){
+            pattern = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @return the name of a pattern
+ */
+std::string ImageGenerator::patternName(SyntheticPattern pattern){
+    switch(pattern){
+        case SyntheticPattern::Noise:
+            return "noise";
+        case SyntheticPattern::Blobs:
+            return "blobs";
+        case SyntheticPattern::Spiral:
+            return "spiral";
+        default:
+            return "checkerboard";
+    }
+}
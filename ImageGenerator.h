@@ -0,0 +1,51 @@
+#ifndef _IMAGEGENERATOR_H
+#define _IMAGEGENERATOR_H
+#include <vector>
+#include <string>
+
+/**
+ * Foreground patterns of the synthetic test images. Pixels meant to be foreground are >= 128.
+ *
+ * Noise - uniform random grey levels, about half the pixels are foreground in many small components.
+ * Blobs - sparse bright discs on a dark noisy background, a few mid-sized components.
+ * Spiral - a single two-pixel wide rectangular spiral that covers half of the image as one giant component.
+ * Checkerboard - alternating pixels, every foreground pixel is its own 4-connected component (the worst case for labeling).
+ */
+enum class SyntheticPattern { Noise, Blobs, Spiral, Checkerboard };
+
+/**
+ * ImageGenerator class
+ *
+ * Generates synthetic 8-bit images of any size for benchmarks and tests. The same pattern,
+ * size and seed always give the same image.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+class ImageGenerator{
+    public:
+        /**
+         * @return a width*height image with the given pattern, in row order
+         */
+        static std::vector<unsigned char> generate(SyntheticPattern pattern, int width, int height, unsigned int seed = 42);
+
+        /**
+         * Writes an 8-bit image to a binary PGM (P5) file
+         * @return true if the file was written
+         */
+        static bool writePGM(const std::string & fileName, const std::vector<unsigned char> & image, int width, int height);
+
+        /**
+         * Looks up a pattern by name (noise, blobs, spiral or checkerboard)
+         * @return false if the name is not a pattern
+         */
+        static bool parsePattern(const std::string & name, SyntheticPattern & pattern);
+
+        /**
+         * @return the name of a pattern
+         */
+        static std::string patternName(SyntheticPattern pattern);
+};
+
+#endif
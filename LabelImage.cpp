@@ -0,0 +1,123 @@
+/**
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "LabelImage.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+/**
+ * Sizes the label image and clears it. 16-bit labels are used when maxID + 1 fits in 16 bits,
+ * and the storage of the other width is released.
+ *
+ * @param width The width of the image.
+ * @param height The height of the image.
+ * @param maxID The largest component ID that will be stored (-1 if there are no components).
+ */
+void LabelImage::reset(int width, int height, int maxID){
+    this->width = width;
+    this->height = height;
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    wide = maxID + 1 > 0xFFFF;
+    if(wide){
+        std::vector<uint16_t>().swap(narrowLabels);
+        wideLabels.assign(pixelCount, 0);
+    }else{
+        std::vector<uint32_t>().swap(wideLabels);
+        narrowLabels.assign(pixelCount, 0);
+    }
+}
+
+/**
+ * Labels a horizontal run of pixels.
+ *
+ * @param y The row of the run.
+ * @param xStart The first pixel of the run.
+ * @param xEnd The last pixel of the run (inclusive).
+ * @param id The component ID.
+ */
+void LabelImage::fillRun(int y, int xStart, int xEnd, int id){
+    size_t begin = static_cast<size_t>(y)*width + xStart;
+    size_t end = static_cast<size_t>(y)*width + xEnd + 1;
+    if(wide){
+        std::fill(wideLabels.begin() + begin, wideLabels.begin() + end, static_cast<uint32_t>(id) + 1);
+    }else{
+        std::fill(narrowLabels.begin() + begin, narrowLabels.begin() + end, static_cast<uint16_t>(id + 1));
+    }
+}
+
+/**
+ * @return true if the labels are 32-bit
+ */
+bool LabelImage::isWide() const{
+    return wide;
+}
+
+/**
+ * @return the 16-bit labels, or nullptr if the labels are 32-bit
+ */
+const uint16_t * LabelImage::narrowData() const{
+    return wide ? nullptr : narrowLabels.data();
+}
+
+/**
+ * @return the 32-bit labels, or nullptr if the labels are 16-bit
+ */
+const uint32_t * LabelImage::wideData() const{
+    return wide ? wideLabels.data() : nullptr;
+}
+
+/**
+ * Writes the labels to a 16-bit PGM. Each pixel is written as its component ID + 1
+ * (0 for no component), most significant byte first as the PGM format requires.
+ *
+ * @param fileName The file path of the output image.
+ * @return true if the file is successfully written; false if otherwise.
+ */
+bool LabelImage::writePGM(const std::string & fileName) const{
+    if(wide){
+        std::cerr << "Error: too many components for a 16-bit label image: " << fileName << "\n";
+        return false;
+    }
+
+    std::ofstream out(fileName, std::ios::binary);
+    if(!out){
+        std::cerr << "Error: Unable to write file " << fileName << "\n";
+        return false;
+    }
+    out << "P5\n" << width << " " << height << "\n65535\n";
+
+    //write a row at a time in big-endian byte order
+    std::vector<unsigned char> row(static_cast<size_t>(width) * 2);
+    for(int y = 0; y < height; ++y){
+        const uint16_t * labels = narrowLabels.data() + static_cast<size_t>(y)*width;
+        for(int x = 0; x < width; ++x){
+            row[2*x] = static_cast<unsigned char>(labels[x] >> 8);
+            row[2*x + 1] = static_cast<unsigned char>(labels[x] & 0xFF);
+        }
+        out.write(reinterpret_cast<const char *>(row.data()), row.size());
+    }
+
+    if(!out){
+        std::cerr << "Error writing binary block of label PGM.\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @return the width of the image
+ */
+int LabelImage::getWidth() const{
+    return width;
+}
+
+/**
+ * @return the height of the image
+ */
+int LabelImage::getHeight() const{
+    return height;
+}
@@ -0,0 +1,90 @@
+#ifndef _LABELIMAGE_H
+#define _LABELIMAGE_H
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * LabelImage class
+ *
+ * Per-pixel component labels of an image. A pixel holds 0 if it is not part of a kept component,
+ * and the component's ID + 1 otherwise, so the component that contains a pixel is found in O(1).
+ * Labels are 16-bit when every ID fits (up to 65534 components) and 32-bit otherwise,
+ * which keeps the common case at two bytes per pixel.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+class LabelImage{
+    private:
+        int width = 0, height = 0; //dimensions of the image
+        bool wide = false; //true when the labels are 32-bit
+        std::vector<uint16_t> narrowLabels; //labels when they fit in 16 bits
+        std::vector<uint32_t> wideLabels; //labels when they do not
+
+    public:
+        /**
+         * Sizes the image for labels up to maxID + 1 and clears every pixel to 0
+         */
+        void reset(int width, int height, int maxID);
+
+        /**
+         * Labels pixels xStart to xEnd (both inclusive) of row y with a component ID
+         */
+        void fillRun(int y, int xStart, int xEnd, int id);
+
+        /**
+         * Labels pixel (x, y) with a component ID
+         */
+        void set(int x, int y, int id){
+            size_t index = static_cast<size_t>(y)*width + x;
+            if(wide){
+                wideLabels[index] = static_cast<uint32_t>(id) + 1;
+            }else{
+                narrowLabels[index] = static_cast<uint16_t>(id + 1);
+            }
+        }
+
+        /**
+         * @return the ID of the component that contains pixel (x, y), or -1 if there is none
+         */
+        int at(int x, int y) const{
+            size_t index = static_cast<size_t>(y)*width + x;
+            return (wide ? static_cast<int>(wideLabels[index]) : static_cast<int>(narrowLabels[index])) - 1;
+        }
+
+        /**
+         * @return true if the labels are 32-bit, false if they are 16-bit
+         */
+        bool isWide() const;
+
+        /**
+         * @return the raw 16-bit labels (ID + 1, 0 for no component), or nullptr if the labels are 32-bit
+         */
+        const uint16_t * narrowData() const;
+
+        /**
+         * @return the raw 32-bit labels (ID + 1, 0 for no component), or nullptr if the labels are 16-bit
+         */
+        const uint32_t * wideData() const;
+
+        /**
+         * Writes the labels as a 16-bit PGM (maxVal 65535, big-endian samples)
+         * @return false if the file cannot be written or a label does not fit in 16 bits
+         */
+        bool writePGM(const std::string & fileName) const;
+
+        /**
+         * @return the width of the image
+         */
+        int getWidth() const;
+
+        /**
+         * @return the height of the image
+         */
+        int getHeight() const;
+};
+
+#endif
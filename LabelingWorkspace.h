@@ -0,0 +1,67 @@
+#ifndef _LABELINGWORKSPACE_H
+#define _LABELINGWORKSPACE_H
+#include "ConnectedComponent.h"
+#include "ForegroundBitmap.h"
+#include "UnionFind.h"
+#include <vector>
+#include <utility>
+
+/**
+ * LabelingWorkspace struct
+ *
+ * The scratch buffers used by the labeling engines while extracting components. A processor keeps
+ * one workspace for its whole life, and the engines clear and refill the buffers instead of creating
+ * new ones, so std::vector keeps their capacity from one call to the next. Once the largest image so
+ * far has been labeled, labeling another image of the same size or smaller allocates nothing here.
+ *
+ * Nothing in the workspace outlives the call that fills it, so copying a processor does not copy it.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+struct LabelingWorkspace{
+    ForegroundBitmap foreground; //the thresholded image
+
+    //Breadth First Search and union-find engines
+    std::vector<int> labels; //label of every pixel, -1 for background and unvisited pixels
+    std::vector< std::pair<int, int> > pixels; //pixels of the component being flood filled, which is also the search queue
+
+    //union-find and run-length engines
+    UnionFind sets; //provisional labels of the whole image
+    std::vector<int> labelSizes; //number of pixels given each provisional label
+    std::vector<int> rootSizes; //number of pixels in each set, indexed by its root
+    std::vector<int> finalIDs; //component ID of each provisional label, -1 if the component is too small
+    std::vector<int> componentSizes; //number of pixels in each kept component
+    std::vector<ConnectedComponent::Statistics> componentStatistics; //moment and intensity sums of each kept component
+
+    //union-find engine
+    std::vector<int> stripStart; //first row of each strip
+    std::vector<UnionFind> stripSets; //provisional labels of each strip
+    std::vector< std::vector<int> > stripLabelSizes; //number of pixels given each provisional label of each strip
+    std::vector<int> labelOffset; //first label of each strip once the strip forests are joined
+    std::vector<int> cursors; //write position shared by the labels of one component within a strip
+    std::vector<int> cursorOwner; //label whose cursor each label uses
+    std::vector<int> filled; //pixels of each component handed out to the strips so far
+    std::vector<int> ownerStrip; //last strip that was given a cursor in each component
+    std::vector<int> ownerLabel; //label that owns that cursor
+    std::vector<int> ownerSlot; //slot of the statistics summed by each cursor owner
+    std::vector<int> slotComponent; //component of each slot
+    std::vector<ConnectedComponent::Statistics> slotStatistics; //moment and intensity sums of each slot
+    std::vector<ConnectedComponent::PixelList> componentPixels; //pixels of each component (in the arena), moved into the components
+
+    //run-length engine
+    std::vector<ConnectedComponent::Run> runs; //every run in raster order
+    std::vector<int> runLabels; //provisional label of each run
+    std::vector<int> componentRunCounts; //number of runs in each component
+    std::vector<ConnectedComponent::RunList> componentRuns; //runs of each component (in the arena), moved into the components
+
+    /**
+     * Frees every buffer (the next extraction allocates them again)
+     */
+    void release(){
+        *this = LabelingWorkspace();
+    }
+};
+
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "Logger.h"
+#include <atomic>
+#include <mutex>
+
+namespace{
+    /**
+     * The state shared by every Logger call. The buffer is written out when the program exits.
+     */
+    struct LoggerState{
+        std::atomic<Verbosity> verbosity{Verbosity::Normal};
+        std::mutex mutex; //guards the buffer and the sink
+        std::string buffer; //lines not yet written to the sink
+        std::ostream * sink = &std::cout;
+
+        LoggerState(){
+            buffer.reserve(Logger::bufferSize);
+        }
+
+        ~LoggerState(){
+            std::lock_guard<std::mutex> lock(mutex);
+            writeBuffer();
+            sink->flush();
+        }
+
+        //hands the buffered lines to the sink (the mutex must be held)
+        void writeBuffer(){
+            sink->write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    };
+
+    LoggerState & state(){
+        static LoggerState loggerState;
+        return loggerState;
+    }
+}
+
+/**
+ * Sets the verbosity of the lines that are written from now on.
+ *
+ * @param level Quiet, Normal or Verbose.
+ */
+void Logger::setVerbosity(Verbosity level){
+    state().verbosity.store(level, std::memory_order_relaxed);
+}
+
+/**
+ * @return The current verbosity.
+ */
+Verbosity Logger::getVerbosity(){
+    return state().verbosity.load(std::memory_order_relaxed);
+}
+
+/**
+ * @param level The level of a line.
+ * @return True if lines of that level are written at the current verbosity.
+ */
+bool Logger::isEnabled(Verbosity level){
+    return level <= getVerbosity();
+}
+
+/**
+ * Writes the buffered lines to the current sink, then sends the lines that follow to another one.
+ *
+ * @param sink The stream to write to, which must outlive the logger or be replaced before it is destroyed.
+ */
+void Logger::setSink(std::ostream & sink){
+    LoggerState & logger = state();
+    std::lock_guard<std::mutex> lock(logger.mutex);
+    logger.writeBuffer();
+    logger.sink = &sink;
+}
+
+/**
+ * Writes the buffered lines to the sink and flushes it, for example before writing to the sink directly.
+ */
+void Logger::flush(){
+    LoggerState & logger = state();
+    std::lock_guard<std::mutex> lock(logger.mutex);
+    logger.writeBuffer();
+    logger.sink->flush();
+}
+
+/**
+ * Adds a formatted line to the buffer. The buffer is written to the sink, without flushing it,
+ * once it holds bufferSize bytes or more.
+ *
+ * @param line The line, with its newline.
+ */
+void Logger::append(std::string_view line){
+    LoggerState & logger = state();
+    std::lock_guard<std::mutex> lock(logger.mutex);
+    logger.buffer.append(line);
+    if(logger.buffer.size() >= bufferSize){
+        logger.writeBuffer();
+    }
+}
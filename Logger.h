@@ -0,0 +1,87 @@
+#ifndef _LOGGER_H
+#define _LOGGER_H
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+/**
+ * How much the command-line tool and the library report.
+ *
+ * Quiet - only the results that were asked for (component counts, sweeps, statistics) and errors.
+ * Normal - also the progress of each step and one line per file of a batch.
+ * Verbose - also per-item diagnostics, such as the bounding box of every component and every file written.
+ */
+enum class Verbosity { Quiet, Normal, Verbose };
+
+/**
+ * Logger class
+ *
+ * Writes status lines to a sink (std::cout by default) at a chosen verbosity. A line is only formatted if
+ * the current verbosity reaches its level, so diagnostics that are switched off cost a single comparison.
+ * Lines are collected in a buffer of bufferSize bytes and handed to the sink whole when it fills up,
+ * without flushing the sink, so thousands of lines cost a handful of writes. flush() writes out what is
+ * buffered and flushes the sink; it is also called when the program exits.
+ *
+ * Safe to use from several threads: each line is formatted on its own thread and appended under a lock,
+ * so lines are never interleaved.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+class Logger{
+    public:
+        //the buffered lines are written to the sink once they reach this many bytes
+        static constexpr size_t bufferSize = 64 * 1024;
+
+        /**
+         * Sets the verbosity of the lines that are written from now on (Normal by default)
+         */
+        static void setVerbosity(Verbosity level);
+
+        /**
+         * @return the current verbosity
+         */
+        static Verbosity getVerbosity();
+
+        /**
+         * @return true if lines of the given level are written at the current verbosity
+         */
+        static bool isEnabled(Verbosity level);
+
+        /**
+         * Writes out the buffered lines, then sends the lines that follow to sink, which must outlive the logger or be replaced
+         */
+        static void setSink(std::ostream & sink);
+
+        /**
+         * Writes out the buffered lines and flushes the sink
+         */
+        static void flush();
+
+        /**
+         * Writes one line (a newline is added) made of the given values, if level is enabled
+         */
+        template <typename... Args> static void log(Verbosity level, const Args &... args){
+            if(!isEnabled(level)){
+                return;
+            }
+            thread_local std::ostringstream line;
+            //each line starts empty and with the default formatting
+            line.str("");
+            line.flags(std::ios_base::dec | std::ios_base::skipws);
+            line.precision(6);
+            (line << ... << args) << '\n';
+            append(line.view());
+        }
+
+    private:
+        /**
+         * Adds a formatted line to the buffer, writing the buffer to the sink when it is full
+         */
+        static void append(std::string_view line);
+};
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "MappedFile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * Default constructor
+ */
+MappedFile::MappedFile(): mappedData(nullptr), mappedSize(0){}
+
+/**
+ * Destructor - releases the mapping
+ */
+MappedFile::~MappedFile(){
+    close();
+}
+
+/**
+ * Move constructor - takes over the mapping and leaves the other object empty
+ */
+MappedFile::MappedFile(MappedFile && file): mappedData(file.mappedData), mappedSize(file.mappedSize){
+    file.mappedData = nullptr;
+    file.mappedSize = 0;
+}
+
+/**
+ * Move Assignment Operator - releases this mapping and takes over the other one
+ */
+MappedFile & MappedFile::operator=(MappedFile && file){
+    if(this != &file){
+        close();
+        mappedData = file.mappedData;
+        mappedSize = file.mappedSize;
+        file.mappedData = nullptr;
+        file.mappedSize = 0;
+    }
+    return *this;
+}
+
+/**
+ * Maps a regular file read-only.
+ * The file descriptor is closed straight away, the mapping stays valid until close().
+ *
+ * @param fileName The file to map.
+ * @return true if the file was mapped.
+ */
+bool MappedFile::open(const std::string & fileName){
+    close();
+
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0){
+        ::close(fd);
+        return false;
+    }
+
+    void * mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(mapping == MAP_FAILED){
+        return false;
+    }
+
+    //the labeling engines scan the raster front to back
+    madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+
+    mappedData = static_cast<const unsigned char *>(mapping);
+    mappedSize = info.st_size;
+    return true;
+}
+
+/**
+ * Unmaps the file if one is mapped.
+ */
+void MappedFile::close(){
+    if(mappedData){
+        munmap(const_cast<unsigned char *>(mappedData), mappedSize);
+        mappedData = nullptr;
+        mappedSize = 0;
+    }
+}
+
+/**
+ * @return a pointer to the first byte of the file, nullptr if nothing is mapped
+ */
+const unsigned char * MappedFile::data() const{
+    return mappedData;
+}
+
+/**
+ * @return the size of the mapping in bytes
+ */
+size_t MappedFile::size() const{
+    return mappedSize;
+}
+
+/**
+ * Checks whether a file can be mapped.
+ *
+ * @param fileName The file to check.
+ * @return The size of the file in bytes, or -1 if it is not a regular file.
+ */
+long long MappedFile::regularFileSize(const std::string & fileName){
+    struct stat info;
+    if(stat(fileName.c_str(), &info) != 0 || !S_ISREG(info.st_mode)){
+        return -1;
+    }
+    return info.st_size;
+}
@@ -0,0 +1,74 @@
+#ifndef _MAPPEDFILE_H
+#define _MAPPEDFILE_H
+#include <string>
+#include <cstddef>
+
+/**
+ * MappedFile class
+ *
+ * Read-only memory mapping of a whole file (POSIX mmap).
+ * Pages are only read from disk when they are first touched, so mapping a large
+ * image costs no copy and no read of the parts that are never used.
+ * The mapping is released when the object is destroyed. It can be moved but not copied.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+class MappedFile{
+    private:
+        const unsigned char * mappedData; //start of the mapping, nullptr if nothing is mapped
+        size_t mappedSize; //size of the mapping in bytes
+
+    public:
+        /**
+         * Default constructor - nothing mapped
+         */
+        MappedFile();
+
+        /**
+         * Destructor - unmaps the file
+         */
+        ~MappedFile();
+
+        MappedFile(const MappedFile & file) = delete;
+        MappedFile & operator=(const MappedFile & file) = delete;
+
+        /**
+         * Move constructor
+         */
+        MappedFile(MappedFile && file);
+
+        /**
+         * Move Assignment Operator
+         */
+        MappedFile & operator=(MappedFile && file);
+
+        /**
+         * Maps a file, unmapping any file that was mapped before
+         * @return true if the file was mapped, false if it could not be opened or is not a regular file
+         */
+        bool open(const std::string & fileName);
+
+        /**
+         * Unmaps the file
+         */
+        void close();
+
+        /**
+         * @return a pointer to the first byte of the file
+         */
+        const unsigned char * data() const;
+
+        /**
+         * @return the size of the file in bytes
+         */
+        size_t size() const;
+
+        /**
+         * @return the size of a file in bytes, or -1 if it is not a regular file (pipes, terminals, missing files)
+         */
+        static long long regularFileSize(const std::string & fileName);
+};
+
+#endif
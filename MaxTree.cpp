@@ -0,0 +1,177 @@
+/**
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "MaxTree.h"
+#include <iostream>
+#include <array>
+#include <limits>
+
+/**
+ * Finds the root of a pixel in the union-find used while building, compressing the path along the way.
+ */
+static int findRoot(std::vector<int> & zpar, int pixel){
+    int root = pixel;
+    while(zpar[root] != root){
+        root = zpar[root];
+    }
+    while(zpar[pixel] != root){
+        int next = zpar[pixel];
+        zpar[pixel] = root;
+        pixel = next;
+    }
+    return root;
+}
+
+/**
+ * Builds the max-tree of an image (Berger et al.'s union-find construction).
+ *
+ * The pixels are visited from the brightest to the darkest. Each pixel becomes the parent of the
+ * roots of the already visited neighbours it touches, so every pixel ends up below the first darker
+ * (or equally bright) pixel that joined it to the rest of the image. A second pass from the darkest
+ * pixel points every pixel at the canonical pixel of its node, and a node is made for each canonical pixel.
+ *
+ * @param image The 8-bit image, width*height bytes in row order.
+ * @param width The width of the image.
+ * @param height The height of the image.
+ * @param connectivity 4 or 8.
+ * @return true if the tree was built; false if the connectivity is not supported or the image has
+ *         more pixels than an int can index (the nodes, areas and sorted pixels are all ints).
+ */
+bool MaxTree::build(const unsigned char * image, int width, int height, int connectivity){
+    if(connectivity != 4 && connectivity != 8){
+        std::cerr << "Unsupported connectivity: " << connectivity << " (must be 4 or 8)" << "\n";
+        return false;
+    }
+    if(static_cast<long long>(width) * height > std::numeric_limits<int>::max()){
+        std::cerr << "Error: image too large for a max-tree: " << width << "x" << height << " (at most " << std::numeric_limits<int>::max() << " pixels)\n";
+        return false;
+    }
+
+    this->width = width;
+    this->height = height;
+    nodeLevel.clear();
+    nodeArea.clear();
+    nodeParent.clear();
+    int pixelCount = width * height;
+    if(width <= 0 || height <= 0){
+        return true;
+    }
+
+    //counting sort of the pixels by grey level, brightest first
+    std::array<int, 257> levelStart{};
+    for(int p = 0; p < pixelCount; ++p){
+        ++levelStart[255 - image[p] + 1];
+    }
+    for(int level = 1; level < 257; ++level){
+        levelStart[level] += levelStart[level - 1];
+    }
+    std::vector<int> sorted(pixelCount);
+    for(int p = 0; p < pixelCount; ++p){
+        sorted[levelStart[255 - image[p]]++] = p;
+    }
+
+    //union-find pass, zpar is -1 until a pixel has been visited
+    const int dx[] = {-1, 1, 0, 0, -1, 1, -1, 1};
+    const int dy[] = {0, 0, -1, 1, -1, -1, 1, 1};
+    std::vector<int> parent(pixelCount);
+    std::vector<int> zpar(pixelCount, -1);
+    for(int p : sorted){
+        parent[p] = p;
+        zpar[p] = p;
+        int x = p % width, y = p / width;
+        for(int i = 0; i < connectivity; ++i){
+            int nx = x + dx[i], ny = y + dy[i];
+            if(nx < 0 || nx >= width || ny < 0 || ny >= height){
+                continue;
+            }
+            int q = ny * width + nx;
+            if(zpar[q] == -1){
+                continue;
+            }
+            int root = findRoot(zpar, q);
+            if(root != p){
+                parent[root] = p;
+                zpar[root] = p;
+            }
+        }
+    }
+
+    //canonicalise from the darkest pixel and make a node for every canonical pixel,
+    //so a node always comes after its parent (zpar is reused to hold the node of each pixel)
+    std::vector<int> & nodeOf = zpar;
+    for(int i = pixelCount - 1; i >= 0; --i){
+        int p = sorted[i];
+        int q = parent[p];
+        if(image[parent[q]] == image[q]){
+            parent[p] = q = parent[q];
+        }
+        if(p == q || image[p] != image[q]){
+            nodeOf[p] = static_cast<int>(nodeLevel.size());
+            nodeLevel.push_back(image[p]);
+            nodeArea.push_back(0);
+            nodeParent.push_back(p == q ? nodeOf[p] : nodeOf[q]);
+        }else{
+            nodeOf[p] = nodeOf[q];
+        }
+        ++nodeArea[nodeOf[p]];
+    }
+
+    //add the area of every node to its parent, children first
+    for(int node = static_cast<int>(nodeArea.size()) - 1; node > 0; --node){
+        nodeArea[nodeParent[node]] += nodeArea[node];
+    }
+    return true;
+}
+
+/**
+ * Finds the components at a threshold from the tree. A node is a component at threshold t
+ * when its level is >= t and its parent's level is < t (or it is the root).
+ *
+ * @param threshold Pixels >= threshold are foreground.
+ * @param minValidSize The minimum number of pixels a component must have to be considered valid.
+ * @return The size of every valid component, in no particular order.
+ */
+std::vector<int> MaxTree::componentSizes(unsigned char threshold, int minValidSize) const{
+    std::vector<int> sizes;
+    for(size_t node = 0; node < nodeLevel.size(); ++node){
+        if(nodeLevel[node] < threshold || nodeArea[node] < minValidSize){
+            continue;
+        }
+        int up = nodeParent[node];
+        if(up == static_cast<int>(node) || nodeLevel[up] < threshold){
+            sizes.push_back(nodeArea[node]);
+        }
+    }
+    return sizes;
+}
+
+/**
+ * @return the number of valid components at a threshold
+ */
+int MaxTree::countComponents(unsigned char threshold, int minValidSize) const{
+    return static_cast<int>(componentSizes(threshold, minValidSize).size());
+}
+
+/**
+ * @return the number of nodes in the tree
+ */
+size_t MaxTree::getNodeCount() const{
+    return nodeLevel.size();
+}
+
+/**
+ * @return the width of the image the tree was built from
+ */
+int MaxTree::getWidth() const{
+    return width;
+}
+
+/**
+ * @return the height of the image the tree was built from
+ */
+int MaxTree::getHeight() const{
+    return height;
+}
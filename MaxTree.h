@@ -0,0 +1,62 @@
+#ifndef _MAXTREE_H
+#define _MAXTREE_H
+#include <vector>
+#include <cstddef>
+
+/**
+ * MaxTree class
+ *
+ * Component tree of the upper level sets of an 8-bit image.
+ * Every node is a connected component of the pixels >= its grey level, and its parent is the
+ * component it joins at the next lower level that changes it. The root is the whole image.
+ *
+ * The tree is built once with a union-find over the pixels sorted by grey level (a counting sort,
+ * so the whole build is close to linear). The components at any threshold t are then the nodes
+ * whose level is >= t and whose parent's level is < t, and their sizes are the areas stored in
+ * the nodes, so no pixel is read again to answer a threshold.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+class MaxTree{
+    private:
+        int width = 0, height = 0; //dimensions of the image
+        std::vector<unsigned char> nodeLevel; //grey level of each node
+        std::vector<int> nodeArea; //number of pixels in the component of each node
+        std::vector<int> nodeParent; //parent of each node, the root is its own parent
+
+    public:
+        /**
+         * Builds the tree of an image with 4 or 8 connectivity, replacing any previous tree
+         * @return false if the connectivity is not 4 or 8, or the image has more than INT_MAX pixels
+         */
+        bool build(const unsigned char * image, int width, int height, int connectivity = 4);
+
+        /**
+         * @return the sizes of the components of the pixels >= threshold that have at least minValidSize pixels
+         */
+        std::vector<int> componentSizes(unsigned char threshold, int minValidSize) const;
+
+        /**
+         * @return the number of components of the pixels >= threshold that have at least minValidSize pixels
+         */
+        int countComponents(unsigned char threshold, int minValidSize) const;
+
+        /**
+         * @return the number of nodes in the tree
+         */
+        size_t getNodeCount() const;
+
+        /**
+         * @return the width of the image the tree was built from
+         */
+        int getWidth() const;
+
+        /**
+         * @return the height of the image the tree was built from
+         */
+        int getHeight() const;
+};
+
+#endif
@@ -6,13 +6,14 @@
  */
 
 #include "PGMimageProcessor.h"
+#include <cctype>
 
 //Constructors and Destructir (Big 6)
 /**
 * Default constructor
 * Initialise an empty PGM image with zero dimensions and no components
 */
-PGMimageProcessor::PGMimageProcessor(): width(0), height(0), maxVal(0), components(), fileName(""){}
+PGMimageProcessor::PGMimageProcessor(): width(0), height(0), maxVal(0), mappedOffset(0), loadMode(LoadMode::Auto), histogram(), histogramValid(false), components(), labelImage(), labelImageValid(false), sizeIndex(), sizeIndexValid(false), fileName(""), threadCount(1){}
 
 /**
 * Destructor
@@ -28,18 +29,27 @@ PGMimageProcessor::PGMimageProcessor(const std::string &inputImageName):
     width(0), 
     height(0), 
     maxVal(0),
+    mappedOffset(0),
+    loadMode(LoadMode::Auto),
+    histogram(),
+    histogramValid(false),
     fileName(inputImageName),
-    components()
+    components(),
+    labelImage(),
+    labelImageValid(false),
+    sizeIndex(),
+    sizeIndexValid(false),
+    threadCount(1)
 {
     bool isPPM = isPPMFile(inputImageName);
     if(isPPM){
         if (!readPGM<true>(inputImageName)) {
-            std::cerr << "Failed to read input PPM file: " << inputImageName << std::endl;
+            std::cerr << "Failed to read input PPM file: " << inputImageName << "\n";
         }
     }
     else{
         if (!readPGM<false>(inputImageName)) {
-            std::cerr << "Failed to read input PGM file: " << inputImageName << std::endl;
+            std::cerr << "Failed to read input PGM file: " << inputImageName << "\n";
         }
     }
 }
@@ -54,7 +64,19 @@ PGMimageProcessor::PGMimageProcessor(const PGMimageProcessor & processor):
     maxVal(processor.maxVal),
     fileName(processor.fileName),
     imageData(processor.imageData),
-    components(processor.components)
+    mappedFile(processor.mappedFile),
+    mappedOffset(processor.mappedOffset),
+    loadMode(processor.loadMode),
+    histogram(processor.histogram),
+    histogramValid(processor.histogramValid),
+    components(processor.components),
+    labelImage(processor.labelImage),
+    labelImageValid(processor.labelImageValid),
+    sizeIndex(processor.sizeIndex),
+    sizeIndexValid(processor.sizeIndexValid),
+    threadCount(processor.threadCount),
+    stats(processor.stats),
+    workspace()
 {}
 
 /**
@@ -67,11 +89,27 @@ PGMimageProcessor::PGMimageProcessor(PGMimageProcessor && processor):
     maxVal(processor.maxVal),
     fileName(std::move(processor.fileName)),
     imageData(std::move(processor.imageData)),
-    components(std::move(processor.components))
+    mappedFile(std::move(processor.mappedFile)),
+    mappedOffset(processor.mappedOffset),
+    loadMode(processor.loadMode),
+    histogram(processor.histogram),
+    histogramValid(processor.histogramValid),
+    components(std::move(processor.components)),
+    labelImage(std::move(processor.labelImage)),
+    labelImageValid(processor.labelImageValid),
+    sizeIndex(std::move(processor.sizeIndex)),
+    sizeIndexValid(processor.sizeIndexValid),
+    threadCount(processor.threadCount),
+    stats(processor.stats),
+    workspace(std::move(processor.workspace))
 {
+    //the components still point into the arena, so it moves with them
+    arena = std::move(processor.arena);
     processor.maxVal = 0;
     processor.height = 0;
     processor.width = 0;
+    processor.labelImageValid = false;
+    processor.sizeIndexValid = false;
 }
 
 /**
@@ -84,8 +122,19 @@ PGMimageProcessor & PGMimageProcessor::operator=(const PGMimageProcessor & proce
         height = processor.height;
         maxVal = processor.maxVal;
         imageData = processor.imageData;
+        mappedFile = processor.mappedFile;
+        mappedOffset = processor.mappedOffset;
+        loadMode = processor.loadMode;
+        histogram = processor.histogram;
+        histogramValid = processor.histogramValid;
         components = processor.components;
+        labelImage = processor.labelImage;
+        labelImageValid = processor.labelImageValid;
+        sizeIndex = processor.sizeIndex;
+        sizeIndexValid = processor.sizeIndexValid;
         fileName = processor.fileName;
+        threadCount = processor.threadCount;
+        stats = processor.stats;
     }
     return *this;
 }
@@ -101,108 +150,208 @@ PGMimageProcessor & PGMimageProcessor::operator=(PGMimageProcessor && processor)
         maxVal = processor.maxVal;
         fileName = std::move(processor.fileName);
         imageData = std::move(processor.imageData);
+        mappedFile = std::move(processor.mappedFile);
+        mappedOffset = processor.mappedOffset;
+        loadMode = processor.loadMode;
+        histogram = processor.histogram;
+        histogramValid = processor.histogramValid;
         components = std::move(processor.components);
+        arena = std::move(processor.arena); //only once the old components are gone, and the new ones point into it
+        labelImage = std::move(processor.labelImage);
+        labelImageValid = processor.labelImageValid;
+        sizeIndex = std::move(processor.sizeIndex);
+        sizeIndexValid = processor.sizeIndexValid;
+        threadCount = processor.threadCount;
+        stats = processor.stats;
+        workspace = std::move(processor.workspace);
     
         processor.width = 0;
         processor.height = 0;
         processor.maxVal = 0;
+        processor.labelImageValid = false;
+        processor.sizeIndexValid = false;
     }
     return *this;
 }
 
+/**
+ * Runs task(0) ... task(count - 1) with each task on its own thread.
+ * Task 0 runs on the calling thread, and this returns once every task has finished.
+ */
+template <typename Task> static void runParallel(int count, Task task){
+    if(count <= 0){
+        return;
+    }
+    std::vector<std::thread> workers;
+    for(int i = 1; i < count; ++i){
+        workers.emplace_back(task, i);
+    }
+    task(0);
+    for(std::thread & worker : workers){
+        worker.join();
+    }
+}
+
 //Core methods
+/**
+ * Replaces the current image with a grey level raster held in memory, such as the next frame of a video.
+ * The pixels are copied into the owned raster, which keeps its capacity, and the components, label image
+ * and size index of the previous image are cleared. The scratch buffers of extractComponents are kept,
+ * so a run of frames of the same size allocates no image-sized buffers after the first one.
+ *
+ * @param image width*height grey levels in row order.
+ * @param width The width of the image.
+ * @param height The height of the image.
+ * @return true if the image was replaced, false if the dimensions are invalid or do not match the pixels.
+ */
+bool PGMimageProcessor::reset(std::span<const unsigned char> image, int width, int height){
+    ProcessingStats::Timer timer(stats, Phase::Read);
+    if(width <= 0 || height <= 0 || image.size() != static_cast<size_t>(width) * height){
+        std::cerr << "Invalid image dimensions: " << width << "x" << height << " for " << image.size() << " pixels\n";
+        return false;
+    }
+
+    mappedFile.reset();
+    imageData.assign(image.begin(), image.end());
+    this->width = width;
+    this->height = height;
+    maxVal = 255;
+    fileName.clear();
+    histogramValid = false;
+    clearComponents();
+
+    timer.addBytes(image.size());
+    timer.addPixels(image.size());
+    return true;
+}
+
 /**
  * Extracts connected components from a grayscale image by using a given threshold.
  * Pixels >= threshold are treated as foreground (255), else background (0).
- * Uses four-neighbour Breadth First Search to label each connected as a foreground component.
+ * Pixels are connected through their four edge neighbours, or also through their four corners with 8-connectivity.
+ * All engines produce the same components with the same IDs,
+ * IDs are given in the order of each component's first pixel in a raster scan.
  * 
  * @param threshold The intensity-threshold to separate foreground and background pixels.
  * @param minValidSize The minimum number of pixels a component must have to be considered valid.
+ * @param engine The labeling algorithm to use (Breadth First Search by default).
+ * @param connectivity 4 or 8 (4 by default).
  * @return Number of valid connected components extracted.
  */
-int PGMimageProcessor::extractComponents(unsigned char threshold, int minValidSize){
-    //clear existing components
+int PGMimageProcessor::extractComponents(unsigned char threshold, int minValidSize, LabelingEngine engine, int connectivity){
+    //clear existing components, then give back all of their pixels at once
     components.clear();
-    
-    //create a temp binary image based on the threshold
-    std::vector<unsigned char> binaryImage = imageData;
-    for(size_t i = 0; i<binaryImage.size(); ++i){
-        if(binaryImage[i] >= threshold){
-            binaryImage[i] = 255; //foreground
-        }else{
-            binaryImage[i] = 0; //background
-        }
+    labelImageValid = false;
+    sizeIndexValid = false;
+    if(arena){
+        arena->reset();
+    }else{
+        arena = std::make_unique<ComponentArena>();
+    }
+
+    if(connectivity != 4 && connectivity != 8){
+        std::cerr << "Unsupported connectivity: " << connectivity << " (must be 4 or 8)\n";
+        return 0;
+    }
+
+    //threshold straight into a packed foreground bitmap, one strip of rows per thread
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    ForegroundBitmap & foreground = workspace.foreground;
+    {
+        ProcessingStats::Timer timer(stats, Phase::Threshold);
+        foreground.resize(width, height);
+        int numStrips = std::max(1, std::min(threadCount, height));
+        runParallel(numStrips, [&](int s){
+            int yBegin = static_cast<int>(static_cast<long long>(height) * s / numStrips);
+            int yEnd = static_cast<int>(static_cast<long long>(height) * (s + 1) / numStrips);
+            foreground.thresholdRows(getImageData(), threshold, yBegin, yEnd);
+        });
+        timer.addBytes(pixelCount);
+        timer.addPixels(pixelCount);
+    }
+
+    //the labeling engines read the packed bitmap, 8 bytes per 64 pixels of a row
+    ProcessingStats::Timer timer(stats, Phase::Label);
+    timer.addBytes(foreground.getWordsPerRow() * sizeof(uint64_t) * height);
+    timer.addPixels(pixelCount);
+    int count;
+    if(engine == LabelingEngine::UnionFind){
+        count = extractComponentsUnionFind(foreground, minValidSize, connectivity);
+    }else if(engine == LabelingEngine::RunLength){
+        count = extractComponentsRunLength(foreground, minValidSize, connectivity);
+    }else{
+        count = extractComponentsBFS(foreground, minValidSize, connectivity);
     }
+    stats.notePeakComponents(components.size());
+    return count;
+}
 
+/**
+ * Uses four (or eight) neighbour Breadth First Search to label each connected as a foreground component.
+ *
+ * @param foreground The thresholded image.
+ * @param minValidSize The minimum number of pixels a component must have to be considered valid.
+ * @param connectivity 4 or 8.
+ * @return Number of valid connected components extracted.
+ */
+int PGMimageProcessor::extractComponentsBFS(const ForegroundBitmap & foreground, int minValidSize, int connectivity){
     //use lables to track which pixels have been processed
-    std::vector<int> labels(width*height, -1); //stores the connected components - checks if pixel visited
+    std::vector<int> & labels = workspace.labels; //stores the connected components - checks if pixel visited
+    labels.assign(static_cast<size_t>(width)*height, -1);
     int componentID = 0;
+    const unsigned char * imageData = getImageData();
+
+    //neighbour offsets in the order they are checked: N, E, S, W, then the diagonals NE, SE, SW, NW for 8-connectivity
+    static const int neighbourX[8] = {0, 1, 0, -1, 1, 1, -1, -1};
+    static const int neighbourY[8] = {-1, 0, 1, 0, -1, 1, 1, -1};
 
     //loop through each pixel in the image
     for(int y = 0; y< height; ++y){
         for(int x = 0; x< width; ++x){
             int index = y*width+x;
 
-            if(binaryImage[index] ==255 && labels[index] == -1){ //checks if the components hasnt been processed (index == -1) and its a foreground pixel
-                //create a new component
-                std::vector<std::pair<int, int>> pixels;
-                std::queue<std::pair<int, int>> queue; //We use bfs to search for connected pixels
+            if(labels[index] == -1 && foreground.test(x, y)){ //checks if the components hasnt been processed (index == -1) and its a foreground pixel
+                //start a new component - every pixel is added to the list once, in the order it is found,
+                //so the list doubles as the search queue and head walks along it
+                std::vector<std::pair<int, int>> & pixels = workspace.pixels;
+                pixels.clear();
+                ConnectedComponent::Statistics statistics; //moments and intensity, summed as pixels are found
 
-                queue.push({x, y}); //add component to the queue
                 labels[index] = componentID; //mark as visited
-                binaryImage[index] = 0;
                 pixels.push_back({x, y});
+                statistics.addPixel(x, y);
+                statistics.addIntensity(imageData[index]);
 
-                while(!queue.empty()){
-                    std::pair<int, int> current = queue.front();
-                    int currX = current.first; //x-coord
-                    int currY = current.second; //y-coord
-                    
-                    queue.pop(); //remove the first element
-
-                    //check 4 neighbours (N, E, S, W)
-                    std::vector<std::pair<int, int>> neighbours;
-                    
-                    //north neighbour (x, y-1)
-                    neighbours.push_back(std::make_pair(currX, currY - 1));
-
-                    //east neighbour (x+1, y)
-                    neighbours.push_back(std::make_pair(currX + 1, currY));
-                    
-                    //south neighbour (x, y+1)
-                    neighbours.push_back(std::make_pair(currX, currY + 1));
-                    
-                    //west neighbour (x-1, y)
-                    neighbours.push_back(std::make_pair(currX - 1, currY));
+                for(size_t head = 0; head < pixels.size(); ++head){
+                    int currX = pixels[head].first; //x-coord
+                    int currY = pixels[head].second; //y-coord
 
                     //check each neighnour
-                    for(size_t i = 0; i<neighbours.size(); ++i){
-                        int nx = neighbours[i].first; //x-coord of neighbour
-                        int ny = neighbours[i].second; //y-coord of neighbour
+                    for(int i = 0; i < connectivity; ++i){
+                        int nx = currX + neighbourX[i]; //x-coord of neighbour
+                        int ny = currY + neighbourY[i]; //y-coord of neighbour
 
                         //check if neighbour is in image boundaries
                         if((nx >= 0 && nx < width) &&( ny >= 0 && ny < height)){
                             int neighbourIndex = ny*width + nx; //1d index
 
                             //check if the neighbour is a forground and hasn't been processed
-                            if(binaryImage[neighbourIndex] == 255 && labels[neighbourIndex] == -1){
-                                //add neighbour to queue
-                                queue.push(std::make_pair(nx, ny));
-
+                            if(labels[neighbourIndex] == -1 && foreground.test(nx, ny)){
                                 //mark it - current component
                                 labels[neighbourIndex] = componentID;
-                                binaryImage[neighbourIndex] = 0;
 
-                                //add to list of pixels in this component
+                                //add to list of pixels in this component (and so to the queue)
                                 pixels.push_back(std::make_pair(nx, ny));
+                                statistics.addPixel(nx, ny);
+                                statistics.addIntensity(imageData[neighbourIndex]);
                             }
                         }
                     }
                 }
                 //after connected pixels are processed - check if the component is big enough
                 if(pixels.size() >= static_cast<size_t> (minValidSize)){
-                    //create a new ConnectedComponent and add it to the component list
-                    components.push_back(std::make_shared<ConnectedComponent>(componentID, pixels));
+                    //create a new ConnectedComponent with an exactly sized copy of the pixels in the arena and add it to the component list
+                    components.emplace_back(componentID, ConnectedComponent::PixelList(pixels.begin(), pixels.end(), arena.get()), statistics);
                     componentID++;
                 }
             }
@@ -211,6 +360,361 @@ int PGMimageProcessor::extractComponents(unsigned char threshold, int minValidSi
     return components.size();
 }
 
+/**
+ * Resolves the equivalences recorded by a raster-scan labeling pass.
+ * Roots are always smaller than the labels below them, so a root's final ID is known before any of
+ * its children are visited, and the IDs follow the order of each component's first label.
+ *
+ * Reads sets and labelSizes from the workspace, and fills its finalIDs (the component ID of each
+ * provisional label, -1 if its component is too small) and componentSizes (indexed by component ID).
+ *
+ * @param workspace The buffers of the extraction.
+ * @param minValidSize The minimum number of pixels a component must have to be kept.
+ */
+static void resolveLabels(LabelingWorkspace & workspace, int minValidSize){
+    UnionFind & sets = workspace.sets;
+    const std::vector<int> & labelSizes = workspace.labelSizes;
+    std::vector<int> & finalIDs = workspace.finalIDs;
+    std::vector<int> & rootSizes = workspace.rootSizes;
+    std::vector<int> & componentSizes = workspace.componentSizes;
+    finalIDs.assign(sets.size(), -1);
+    rootSizes.assign(sets.size(), 0);
+    for(int label = 0; label < sets.size(); ++label){
+        rootSizes[sets.find(label)] += labelSizes[label];
+    }
+
+    componentSizes.clear();
+    for(int label = 0; label < sets.size(); ++label){
+        int root = sets.find(label);
+        if(root == label){
+            if(rootSizes[label] >= minValidSize){
+                finalIDs[label] = componentSizes.size();
+                componentSizes.push_back(rootSizes[label]);
+            }
+        }else{
+            finalIDs[label] = finalIDs[root];
+        }
+    }
+}
+
+/**
+ * Two-pass raster scan labeling.
+ *
+ * The image is split into horizontal strips, one per thread (a single strip when threadCount is 1).
+ * The first pass visits each strip's foreground pixels in memory order, straight from the set bits of
+ * the bitmap so whole words of background are skipped, and gives each foreground pixel the label
+ * of its west or north neighbour, creating a new provisional label when neither is foreground and
+ * recording an equivalence in the strip's union-find when both are. Pixel counts are kept per label.
+ * With 8-connectivity the scan follows a decision tree over the north, north-east, north-west and west
+ * neighbours, which needs at most one union per pixel and reads the corners only when north is background.
+ *
+ * The strip forests are then joined into one, and the labels on either side of every seam are merged
+ * concurrently. Equivalences are resolved label by label (not pixel by pixel), and the second pass
+ * writes every pixel straight into its final place in a component whose size is already known.
+ * Since the root of every set is its first label, component IDs and pixel order match the serial scan,
+ * and the IDs match the BFS engine.
+ *
+ * @param foreground The thresholded image.
+ * @param minValidSize The minimum number of pixels a component must have to be considered valid.
+ * @param connectivity 4 or 8.
+ * @return Number of valid connected components extracted.
+ */
+int PGMimageProcessor::extractComponentsUnionFind(const ForegroundBitmap & foreground, int minValidSize, int connectivity){
+    int numStrips = std::max(1, std::min(threadCount, height));
+    std::vector<int> & stripStart = workspace.stripStart; //first row of each strip
+    stripStart.resize(numStrips + 1);
+    for(int s = 0; s <= numStrips; ++s){
+        stripStart[s] = static_cast<int>(static_cast<long long>(height) * s / numStrips);
+    }
+
+    std::vector<int> & labels = workspace.labels; //provisional label of each pixel (local to its strip), -1 is background
+    labels.assign(static_cast<size_t>(width)*height, -1);
+    std::vector<UnionFind> & stripSets = workspace.stripSets;
+    std::vector< std::vector<int> > & stripLabelSizes = workspace.stripLabelSizes; //number of pixels given each provisional label
+    stripSets.resize(numStrips);
+    stripLabelSizes.resize(numStrips);
+
+    //first pass - provisional labels and equivalences, each strip independently
+    runParallel(numStrips, [&](int s){
+        UnionFind & sets = stripSets[s];
+        std::vector<int> & labelSizes = stripLabelSizes[s];
+        sets.clear();
+        labelSizes.clear();
+
+        for(int y = stripStart[s]; y < stripStart[s+1]; ++y){
+            const uint64_t * rowBits = foreground.row(y);
+            int * rowLabels = labels.data() + static_cast<size_t>(y)*width;
+            const int * northLabels = (y > stripStart[s]) ? rowLabels - width : nullptr;
+
+            for(size_t w = 0; w < foreground.getWordsPerRow(); ++w){
+                for(uint64_t bits = rowBits[w]; bits != 0; bits &= bits - 1){
+                    int x = static_cast<int>(w*64) + __builtin_ctzll(bits);
+
+                    int west = (x > 0) ? rowLabels[x-1] : -1;
+                    int north = northLabels ? northLabels[x] : -1;
+                    int label;
+
+                    if(connectivity == 8){
+                        //decision tree - a foreground north neighbour touches every other scanned neighbour,
+                        //so only when it is background do the corners need to be looked at
+                        label = north;
+                        if(label < 0){
+                            int northEast = (northLabels && x + 1 < width) ? northLabels[x+1] : -1;
+                            int northWest = (northLabels && x > 0) ? northLabels[x-1] : -1;
+                            //west and north-west touch each other, so either one stands for both
+                            int westSide = (northWest >= 0) ? northWest : west;
+                            if(northEast >= 0 && westSide >= 0){
+                                label = sets.unite(northEast, westSide);
+                            }else{
+                                label = (northEast >= 0) ? northEast : westSide;
+                            }
+                        }
+                    }else{
+                        if(west >= 0 && north >= 0 && west != north){
+                            sets.unite(west, north);
+                        }
+                        label = (west >= 0) ? west : north;
+                    }
+
+                    if(label < 0){
+                        label = sets.makeSet();
+                        labelSizes.push_back(0);
+                    }
+                    rowLabels[x] = label;
+                    labelSizes[label]++;
+                }
+            }
+        }
+    });
+
+    //join the strip forests - strip s's labels start at labelOffset[s]
+    std::vector<int> & labelOffset = workspace.labelOffset;
+    labelOffset.assign(numStrips + 1, 0);
+    UnionFind & sets = workspace.sets;
+    std::vector<int> & labelSizes = workspace.labelSizes;
+    sets.clear();
+    labelSizes.clear();
+    for(int s = 0; s < numStrips; ++s){
+        labelOffset[s+1] = labelOffset[s] + stripSets[s].size();
+        sets.append(stripSets[s]);
+        labelSizes.insert(labelSizes.end(), stripLabelSizes[s].begin(), stripLabelSizes[s].end());
+    }
+
+    //merge the labels across each seam, all seams at once
+    int reach = (connectivity == 8) ? 1 : 0; //how far left and right of a pixel the row above is touched
+    runParallel(numStrips - 1, [&](int seam){
+        int s = seam + 1;
+        const int * rowLabels = labels.data() + static_cast<size_t>(stripStart[s])*width;
+        const int * northLabels = rowLabels - width;
+        for(int x = 0; x < width; ++x){
+            if(rowLabels[x] < 0){
+                continue;
+            }
+            for(int nx = std::max(0, x - reach); nx <= std::min(width - 1, x + reach); ++nx){
+                if(northLabels[nx] >= 0){
+                    sets.uniteConcurrent(rowLabels[x] + labelOffset[s], northLabels[nx] + labelOffset[s-1]);
+                }
+            }
+        }
+    });
+
+    resolveLabels(workspace, minValidSize);
+    const std::vector<int> & finalIDs = workspace.finalIDs;
+    const std::vector<int> & componentSizes = workspace.componentSizes;
+
+    //give every strip its own write position in each component it touches, in strip order,
+    //so that the strips can be written at the same time and still end up in raster order
+    std::vector<int> & cursors = workspace.cursors; //write position shared by the labels of one component within a strip
+    std::vector<int> & cursorOwner = workspace.cursorOwner; //label whose cursor each label uses
+    std::vector<int> & filled = workspace.filled;
+    std::vector<int> & ownerStrip = workspace.ownerStrip;
+    std::vector<int> & ownerLabel = workspace.ownerLabel;
+    cursors.assign(sets.size(), 0);
+    cursorOwner.assign(sets.size(), 0);
+    filled.assign(componentSizes.size(), 0);
+    ownerStrip.assign(componentSizes.size(), -1);
+    ownerLabel.assign(componentSizes.size(), -1);
+    for(int s = 0; s < numStrips; ++s){
+        for(int label = labelOffset[s]; label < labelOffset[s+1]; ++label){
+            int id = finalIDs[label];
+            if(id < 0){
+                continue;
+            }
+            if(ownerStrip[id] != s){
+                ownerStrip[id] = s;
+                ownerLabel[id] = label;
+                cursors[label] = filled[id];
+            }
+            cursorOwner[label] = ownerLabel[id];
+            filled[id] += labelSizes[label];
+        }
+    }
+
+    //every component's list is allocated at its final size in the arena, and the second pass writes straight into it
+    std::vector<ConnectedComponent::PixelList> & componentPixels = workspace.componentPixels;
+    componentPixels.clear();
+    for(size_t id = 0; id < componentSizes.size(); ++id){
+        componentPixels.emplace_back(componentSizes[id], std::pair<int, int>(), arena.get());
+    }
+
+    //each cursor owner (one per component per strip) also sums the moments and intensity of its pixels,
+    //so the strips never add to the same sums
+    std::vector<int> & ownerSlot = workspace.ownerSlot;
+    std::vector<int> & slotComponent = workspace.slotComponent;
+    ownerSlot.assign(sets.size(), -1);
+    slotComponent.clear();
+    for(int label = 0; label < sets.size(); ++label){
+        if(finalIDs[label] >= 0 && cursorOwner[label] == label){
+            ownerSlot[label] = slotComponent.size();
+            slotComponent.push_back(finalIDs[label]);
+        }
+    }
+    std::vector<ConnectedComponent::Statistics> & slotStatistics = workspace.slotStatistics;
+    slotStatistics.assign(slotComponent.size(), ConnectedComponent::Statistics());
+    const unsigned char * imageData = getImageData();
+
+    //second pass - write each pixel into its component
+    runParallel(numStrips, [&](int s){
+        for(int y = stripStart[s]; y < stripStart[s+1]; ++y){
+            const int * rowLabels = labels.data() + static_cast<size_t>(y)*width;
+            const unsigned char * rowPixels = imageData + static_cast<size_t>(y)*width;
+            for(int x = 0; x < width; ++x){
+                if(rowLabels[x] >= 0){
+                    int label = rowLabels[x] + labelOffset[s];
+                    int id = finalIDs[label];
+                    if(id >= 0){
+                        int owner = cursorOwner[label];
+                        componentPixels[id][cursors[owner]++] = std::make_pair(x, y);
+                        ConnectedComponent::Statistics & statistics = slotStatistics[ownerSlot[owner]];
+                        statistics.addPixel(x, y);
+                        statistics.addIntensity(rowPixels[x]);
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<ConnectedComponent::Statistics> & componentStatistics = workspace.componentStatistics;
+    componentStatistics.assign(componentSizes.size(), ConnectedComponent::Statistics());
+    for(size_t slot = 0; slot < slotComponent.size(); ++slot){
+        componentStatistics[slotComponent[slot]].merge(slotStatistics[slot]);
+    }
+
+    components.reserve(componentPixels.size());
+    for(size_t id = 0; id < componentPixels.size(); ++id){
+        components.emplace_back(id, std::move(componentPixels[id]), componentStatistics[id]);
+    }
+
+    return components.size();
+}
+
+/**
+ * Run-based raster scan labeling.
+ *
+ * Each row of the bitmap is split into horizontal runs of foreground pixels, and each run is given the label of the
+ * first run above it that it touches, merging the labels of any other touching runs in the union-find.
+ * With 8-connectivity a run also touches the runs above that end just before it or start just after it.
+ * The runs above are walked with a single cursor, so each row costs O(runs) after thresholding.
+ * After the equivalences are resolved, the runs are handed to their components as they are,
+ * so no per-pixel coordinate list is ever built.
+ *
+ * @param foreground The thresholded image.
+ * @param minValidSize The minimum number of pixels a component must have to be considered valid.
+ * @param connectivity 4 or 8.
+ * @return Number of valid connected components extracted.
+ */
+int PGMimageProcessor::extractComponentsRunLength(const ForegroundBitmap & foreground, int minValidSize, int connectivity){
+    int reach = (connectivity == 8) ? 1 : 0; //runs touch diagonally with 8-connectivity
+
+    std::vector<ConnectedComponent::Run> & runs = workspace.runs; //every run in raster order
+    std::vector<int> & runLabels = workspace.runLabels; //provisional label of each run
+    std::vector<int> & labelSizes = workspace.labelSizes; //number of pixels given each provisional label
+    UnionFind & sets = workspace.sets;
+    runs.clear();
+    runLabels.clear();
+    labelSizes.clear();
+    sets.clear();
+
+    size_t previousBegin = 0, previousEnd = 0; //runs of the row above
+    for(int y = 0; y < height; ++y){
+        size_t rowBegin = runs.size();
+
+        int x = 0;
+        while(x < width){
+            //find the next run, a word of the bitmap at a time
+            int xStart = foreground.nextForeground(y, x);
+            if(xStart == width){
+                break;
+            }
+            x = foreground.nextBackground(y, xStart);
+            int xEnd = x - 1;
+
+            //skip the runs above that end before this one starts, they cannot touch any later run either
+            while(previousBegin < previousEnd && runs[previousBegin].xEnd < xStart - reach){
+                ++previousBegin;
+            }
+
+            int label = -1;
+            for(size_t above = previousBegin; above < previousEnd && runs[above].xStart <= xEnd + reach; ++above){
+                if(label < 0){
+                    label = runLabels[above];
+                }else if(runLabels[above] != label){
+                    sets.unite(label, runLabels[above]);
+                }
+            }
+            if(label < 0){
+                label = sets.makeSet();
+                labelSizes.push_back(0);
+            }
+
+            runs.push_back({y, xStart, xEnd});
+            runLabels.push_back(label);
+            labelSizes[label] += xEnd - xStart + 1;
+        }
+
+        previousBegin = rowBegin;
+        previousEnd = runs.size();
+    }
+
+    resolveLabels(workspace, minValidSize);
+    const std::vector<int> & finalIDs = workspace.finalIDs;
+
+    //hand each run to its component in raster order, summing its moments in closed form and its grey levels
+    std::vector<ConnectedComponent::RunList> & componentRuns = workspace.componentRuns;
+    std::vector<ConnectedComponent::Statistics> & componentStatistics = workspace.componentStatistics;
+    std::vector<int> & componentRunCounts = workspace.componentRunCounts;
+    componentRuns.clear();
+    componentStatistics.assign(workspace.componentSizes.size(), ConnectedComponent::Statistics());
+    componentRunCounts.assign(workspace.componentSizes.size(), 0);
+    for(size_t i = 0; i < runs.size(); ++i){
+        int id = finalIDs[runLabels[i]];
+        if(id >= 0){
+            componentRunCounts[id]++;
+        }
+    }
+    for(size_t id = 0; id < workspace.componentSizes.size(); ++id){
+        componentRuns.emplace_back(arena.get());
+        componentRuns[id].reserve(componentRunCounts[id]); //one allocation per component, in the arena
+    }
+    const unsigned char * imageData = getImageData();
+    for(size_t i = 0; i < runs.size(); ++i){
+        int id = finalIDs[runLabels[i]];
+        if(id >= 0){
+            const ConnectedComponent::Run & run = runs[i];
+            componentRuns[id].push_back(run);
+            componentStatistics[id].addRun(run.y, run.xStart, run.xEnd);
+            componentStatistics[id].addIntensities(imageData + static_cast<size_t>(run.y)*width + run.xStart, run.xEnd - run.xStart + 1);
+        }
+    }
+
+    components.reserve(componentRuns.size());
+    for(size_t id = 0; id < componentRuns.size(); ++id){
+        components.emplace_back(id, std::move(componentRuns[id]), componentStatistics[id]);
+    }
+
+    return components.size();
+}
+
 /**
  * Filters the current list of components by their size.
  * Keeps only those whose size is between [minSize, maxSize].
@@ -220,25 +724,289 @@ int PGMimageProcessor::extractComponents(unsigned char threshold, int minValidSi
  * @return Number of components that are filtered.
  */
 int PGMimageProcessor::filterComponentsBySize(int minSize, int maxSize){
-    typedef std::vector<std::shared_ptr<ConnectedComponent>> compVecPtr;
-    compVecPtr filtered;
-    compVecPtr::const_iterator i = components.begin();
+    ProcessingStats::Timer timer(stats, Phase::Filter);
+    for(const ConnectedComponent & component : components){
+        timer.addPixels(component.getSize());
+    }
+
+    //removes the components whose size is not between [minSize, maxSize], moving the rest down in place
+    std::erase_if(components, [minSize, maxSize](const ConnectedComponent & component){
+        int components_size = component.getSize();
+        return (components_size < minSize) || (components_size > maxSize);
+    });
+    labelImageValid = false;
+    sizeIndexValid = false;
+
+    if (components.empty()) {
+        Logger::log(Verbosity::Verbose, "No components matched the size criteria!");
+    }
+
+    return components.size();
+}
+
+//row of a run or pixel, so the band writer can treat both kinds of list alike
+static int rowOf(const ConnectedComponent::Run & run){
+    return run.y;
+}
+
+static int rowOf(const std::pair<int, int> & pixel){
+    return pixel.second;
+}
+
+/**
+ * @return true if the runs (or pixels) of a component are in row order, as the raster-scan engines store them.
+ * The pixels found by a Breadth First Search are not.
+ */
+static bool isRowOrdered(const ConnectedComponent & component){
+    auto byRow = [](const auto & a, const auto & b){ return rowOf(a) < rowOf(b); };
+    if(component.isRunLength()){
+        return std::is_sorted(component.getRuns().begin(), component.getRuns().end(), byRow);
+    }
+    return std::is_sorted(component.getPixels().begin(), component.getPixels().end(), byRow);
+}
 
-    //checks if the components size is between [minSize, maxSize]
-    while(i != components.end()){
-        int components_size = (*i) -> getSize();
-        if((components_size >= minSize) && (components_size <= maxSize)){
-            filtered.push_back(*i);
+/**
+ * @return the bounding box of a component clamped to the image, as (x_min, y_min, x_max, y_max)
+ */
+static std::tuple<int, int, int, int> clampedBoundingBox(const ConnectedComponent & component, int width, int height){
+    int x_min = std::max(0, std::min(component.getXMin(), width-1));
+    int y_min = std::max(0, std::min(component.getYMin(), height-1));
+    int x_max = std::max(0, std::min(component.getXMax(), width-1));
+    int y_max = std::max(0, std::min(component.getYMax(), height-1));
+    if (x_min > x_max) std::swap(x_min, x_max);
+    if (y_min > y_max) std::swap(y_min, y_max);
+    return {x_min, y_min, x_max, y_max};
+}
+
+/**
+ * Writes the components to a PGM or PPM file without ever holding the whole output raster.
+ * Rows are rendered into a buffer of about writeBandSize bytes (at least one row), which is written
+ * and then reused for the next band, so the memory used is O(width) whatever the height of the image.
+ * Each band is handed to the stream in one write, large enough for the stream to pass it straight to the file.
+ *
+ * Each band is rendered by threadCount threads, started once per file, each filling its own rows, with the
+ * bounding box outlines clipped to those rows. The pixel lists of a Breadth First Search are not in row order, so they are
+ * written in a second step in which each thread takes a share of every list instead of a share of the rows.
+ * Either way no two threads write the same bytes.
+ *
+ * @param outputFile The name of the file, with its extension.
+ * @param channels 1 for a PGM, 3 for a PPM.
+ * @param drawBoundingBoxes If true (PPM only), the original image is drawn with a red box around each component instead.
+ * @return True if the write is successful, false otherwise.
+ */
+bool PGMimageProcessor::writeRaster(const std::string & outputFile, int channels, bool drawBoundingBoxes){
+    ProcessingStats::Timer timer(stats, Phase::Write);
+    std::ofstream out(outputFile, std::ios::binary);
+    if(!out){
+        std::cerr << "Error: Unable to write file " << outputFile << "\n";
+        return false;
+    }
+
+    //PGM or PPM header
+    out << (channels == 1 ? "P5\n" : "P6\n") << width << " " << height << "\n" << 255 << "\n";
+
+    //one diagnostic line per box, only formatted when it will be written
+    if(drawBoundingBoxes && Logger::isEnabled(Verbosity::Verbose)){
+        for(size_t i = 0; i < components.size(); ++i){
+            auto [x_min, y_min, x_max, y_max] = clampedBoundingBox(components[i], width, height);
+            Logger::log(Verbosity::Verbose, "Component ", i, " bounding box: ", "Xmin: ", x_min, ", Xmax: ", x_max, ", Ymin: ", y_min, ", Ymax: ", y_max);
         }
-        ++i;
     }
 
-    if (filtered.empty()) {
-        std::cerr << "No components matched the size criteria!" << std::endl;
+    //a list in row order is binary searched for each band, any other list is scanned for every band it touches
+    std::vector<char> rowOrdered(components.size(), 0);
+    bool anyUnordered = false;
+    if(!drawBoundingBoxes){
+        for(size_t i = 0; i < components.size(); ++i){
+            rowOrdered[i] = isRowOrdered(components[i]);
+            anyUnordered = anyUnordered || !rowOrdered[i];
+        }
     }
 
-    components = std::move(filtered);
-    return components.size();
+    //components are labeled in raster order, so their top rows only go down and each band only needs to visit a
+    //window of them: from the first one still reaching the band to the last one starting in it
+    auto topRow = [&](size_t i){ return std::get<1>(clampedBoundingBox(components[i], width, height)); };
+    auto bottomRow = [&](size_t i){ return std::get<3>(clampedBoundingBox(components[i], width, height)); };
+    bool topRowsSorted = true;
+    for(size_t i = 1; i < components.size() && topRowsSorted; ++i){
+        topRowsSorted = topRow(i - 1) <= topRow(i);
+    }
+    //without that order every band visits every component
+    size_t first = 0, last = topRowsSorted ? 0 : components.size();
+
+    size_t rowBytes = static_cast<size_t>(width) * channels;
+    int bandRows = static_cast<int>(std::clamp<size_t>(writeBandSize / std::max<size_t>(rowBytes, 1), 1, std::max(height, 1)));
+    std::vector<unsigned char> band(bandRows * rowBytes);
+
+    //moves on to the band starting at row y, or past the last row if the stream failed
+    int yBegin = 0, yEnd = 0;
+    auto startBand = [&](int y){
+        yBegin = out ? y : height;
+        yEnd = std::min(height, yBegin + bandRows);
+        if(topRowsSorted && yBegin < yEnd){
+            while(first < components.size() && bottomRow(first) < yBegin){
+                ++first;
+            }
+            last = std::max(last, first);
+            while(last < components.size() && topRow(last) < yEnd){
+                ++last;
+            }
+        }
+    };
+    startBand(0);
+
+    //the workers are started once and go through the bands together: the last one to finish a band writes it
+    //and sets up the next one while the others wait, so the band buffer is never read and filled at the same time
+    int numParts = std::max(1, std::min(threadCount, bandRows));
+    std::barrier rowsFilled(numParts);
+    std::barrier bandFilled(numParts, [&]() noexcept {
+        out.write(reinterpret_cast<char *>(band.data()), (yEnd - yBegin) * rowBytes);
+        startBand(yEnd);
+    });
+    runParallel(numParts, [&](int part){
+        while(yBegin < yEnd){
+            int partBegin = yBegin + static_cast<int>(static_cast<long long>(yEnd - yBegin) * part / numParts);
+            int partEnd = yBegin + static_cast<int>(static_cast<long long>(yEnd - yBegin) * (part + 1) / numParts);
+            fillBand(band.data() + (partBegin - yBegin) * rowBytes, partBegin, partEnd, channels, drawBoundingBoxes, rowOrdered, first, last);
+            if(anyUnordered){
+                rowsFilled.arrive_and_wait();
+                fillUnordered(band.data(), yBegin, yEnd, channels, rowOrdered, first, last, part, numParts);
+            }
+            bandFilled.arrive_and_wait();
+        }
+    });
+
+    if (!out || out.fail())
+    {
+        std::cerr << "Error writing binary block of " << (channels == 1 ? "PGM" : "PPM") << ".\n";
+        return false;
+    }
+    Logger::log(Verbosity::Verbose, "Data successfully written to ", outputFile);
+    timer.addBytes(rowBytes * height);
+    timer.addPixels(static_cast<size_t>(width) * height);
+
+    out.close();
+    return true;
+}
+
+/**
+ * Renders rows [yBegin, yEnd) of the output, except for the lists that are not in row order (see fillUnordered).
+ * Components are white on black, reading each component's runs or pixels where they are stored. Only the
+ * components in [first, last) whose bounding box reaches the rows are visited, and a list in row order is
+ * entered at the first row by binary search.
+ * With bounding boxes, the rows start as the original image in grey and only the parts of each box's
+ * outline that lie in them are drawn.
+ *
+ * @param band (yEnd - yBegin) rows of width*channels bytes.
+ * @param yBegin The first row to render.
+ * @param yEnd One past the last row to render.
+ * @param channels 1 for a PGM, 3 for a PPM.
+ * @param drawBoundingBoxes If true, draw the original image and the bounding boxes.
+ * @param rowOrdered Whether the list of each component is in row order.
+ * @param first The first component that may reach the rows.
+ * @param last One past the last component that may reach the rows.
+ */
+void PGMimageProcessor::fillBand(unsigned char * band, int yBegin, int yEnd, int channels, bool drawBoundingBoxes, const std::vector<char> & rowOrdered, size_t first, size_t last) const{
+    size_t bandPixels = static_cast<size_t>(yEnd - yBegin) * width;
+
+    if(drawBoundingBoxes){
+        //convert original grayscale to colour
+        const unsigned char * imageData = getImageData() + static_cast<size_t>(yBegin) * width;
+        for(size_t i = 0; i < bandPixels; ++i){
+            band[i * 3] = imageData[i];     // R
+            band[i * 3 + 1] = imageData[i]; // G
+            band[i * 3 + 2] = imageData[i]; // B
+        }
+
+        auto setRed = [&](int x, int y){
+            unsigned char * pixel = band + ((static_cast<size_t>(y) - yBegin) * width + x) * 3;
+            pixel[0] = 255;
+            pixel[1] = 0;
+            pixel[2] = 0;
+        };
+        for(size_t i = first; i < last; ++i){
+            auto [x_min, y_min, x_max, y_max] = clampedBoundingBox(components[i], width, height);
+            if(y_max < yBegin || y_min >= yEnd){
+                continue;
+            }
+            //horizontal lines (top and bottom)
+            for(int y : {y_min, y_max}){
+                if(y >= yBegin && y < yEnd){
+                    for(int x = x_min; x <= x_max; ++x){
+                        setRed(x, y);
+                    }
+                }
+            }
+            //vertical lines (left and right)
+            for(int y = std::max(y_min + 1, yBegin); y < std::min(y_max, yEnd); ++y){
+                setRed(x_min, y);
+                setRed(x_max, y);
+            }
+        }
+        return;
+    }
+
+    std::memset(band, 0, bandPixels * channels);
+    //writes the entries of a run or pixel list that lie in the rows
+    auto fillList = [&](const auto & list, auto fill){
+        auto entry = std::partition_point(list.begin(), list.end(), [yBegin](const auto & item){ return rowOf(item) < yBegin; });
+        for(; entry != list.end() && rowOf(*entry) < yEnd; ++entry){
+            fill(*entry);
+        }
+    };
+
+    for(size_t i = first; i < last; ++i){
+        const ConnectedComponent & component = components[i];
+        if(!rowOrdered[i] || component.getYMax() < yBegin || component.getYMin() >= yEnd){
+            continue;
+        }
+        if(component.isRunLength()){
+            //fill whole runs at once
+            fillList(component.getRuns(), [&](const ConnectedComponent::Run & run){
+                std::memset(band + ((static_cast<size_t>(run.y) - yBegin) * width + run.xStart) * channels, 255, (run.xEnd - run.xStart + 1) * channels);
+            });
+        }else{
+            fillList(component.getPixels(), [&](const std::pair<int, int> & pixel){
+                if(pixel.first >= 0 && pixel.first < width){
+                    std::memset(band + ((static_cast<size_t>(pixel.second) - yBegin) * width + pixel.first) * channels, 255, channels);
+                }
+            });
+        }
+    }
+}
+
+/**
+ * Writes the pixels of the lists that are not in row order (those of a Breadth First Search) that lie in
+ * rows [yBegin, yEnd), once fillBand has rendered those rows. Every list has to be scanned to find them,
+ * so the work is split by list rather than by row: part takes its share of each list. The pixels of the
+ * components are all different, so the parts never write the same bytes.
+ *
+ * @param band (yEnd - yBegin) rows of width*channels bytes.
+ * @param yBegin The first row of the band.
+ * @param yEnd One past the last row of the band.
+ * @param channels 1 for a PGM, 3 for a PPM.
+ * @param rowOrdered Whether the list of each component is in row order.
+ * @param first The first component that may reach the band.
+ * @param last One past the last component that may reach the band.
+ * @param part Which share of each list to write.
+ * @param numParts The number of shares each list is split into.
+ */
+void PGMimageProcessor::fillUnordered(unsigned char * band, int yBegin, int yEnd, int channels, const std::vector<char> & rowOrdered, size_t first, size_t last, int part, int numParts) const{
+    for(size_t i = first; i < last; ++i){
+        const ConnectedComponent & component = components[i];
+        if(rowOrdered[i] || component.getYMax() < yBegin || component.getYMin() >= yEnd){
+            continue;
+        }
+        const ConnectedComponent::PixelList & pixels = component.getPixels();
+        size_t begin = pixels.size() * part / numParts;
+        size_t end = pixels.size() * (part + 1) / numParts;
+        for(size_t p = begin; p < end; ++p){
+            auto [x, y] = pixels[p];
+            if(y >= yBegin && y < yEnd && x >= 0 && x < width){
+                std::memset(band + ((static_cast<size_t>(y) - yBegin) * width + x) * channels, 255, channels);
+            }
+        }
+    }
 }
 
 // Explicitly instantiate the templates that will be used:
@@ -254,6 +1022,212 @@ template bool PGMimageProcessor::readPGM<true>(const std::string &fileName);
 //Specialised template to read in PGM(gray scale) files
 template bool PGMimageProcessor::readPGM<false>(const std::string &fileName);
 
+/**
+ * Reads the next whitespace separated token of a PNM header held in memory, skipping # comments.
+ *
+ * @param data The start of the file.
+ * @param size The size of the file.
+ * @param pos The position to read from, left just after the token.
+ * @param token Set to the token that was read.
+ * @return true if a token was found before the end of the file.
+ */
+static bool nextHeaderToken(const unsigned char * data, size_t size, size_t & pos, std::string & token){
+    while(pos < size){
+        if(data[pos] == '#'){
+            while(pos < size && data[pos] != '\n'){
+                ++pos;
+            }
+        }else if(std::isspace(data[pos])){
+            ++pos;
+        }else{
+            break;
+        }
+    }
+
+    size_t start = pos;
+    while(pos < size && !std::isspace(data[pos]) && data[pos] != '#'){
+        ++pos;
+    }
+    token.assign(reinterpret_cast<const char *>(data + start), pos - start);
+    return pos > start;
+}
+
+/**
+ * Reads the header of a PGM/PPM stream.
+ * Comments (# to the end of the line) may appear between any of the fields, and the
+ * single whitespace character after the max value is consumed.
+ *
+ * @param in The stream, positioned at the start of the file.
+ * @param magicNumber Set to "P5", "P6", or whatever the file starts with.
+ * @param width Set to the width of the image.
+ * @param height Set to the height of the image.
+ * @param maxVal Set to the maximum pixel value.
+ * @return true if all four fields were read.
+ */
+bool PGMimageProcessor::readHeader(std::istream & in, std::string & magicNumber, int & width, int & height, int & maxVal){
+    in >> magicNumber;
+
+    int * fields[3] = {&width, &height, &maxVal};
+    for(int * field : fields){
+        //Skip the comments
+        char ch;
+        while(in >> ch){
+            if(ch == '#'){
+                in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            }else{
+                in.putback(ch);
+                break;
+            }
+        }
+        in >> *field;
+    }
+
+    //consume the newline character after the header
+    in.get();
+    return static_cast<bool>(in);
+}
+
+/**
+ * Decides whether readPGM should memory map a file.
+ * Only regular files can be mapped, so pipes and terminals are always copied.
+ *
+ * @param fileName The file about to be read.
+ * @return true to map the file, false to read it into imageData.
+ */
+bool PGMimageProcessor::shouldMapFile(const std::string & fileName) const{
+    if(loadMode == LoadMode::Copy){
+        return false;
+    }
+    long long fileSize = MappedFile::regularFileSize(fileName);
+    if(fileSize < 0){
+        return false;
+    }
+    return loadMode == LoadMode::Map || static_cast<size_t>(fileSize) >= autoMapSize;
+}
+
+/**
+ * Reads a PGM (P5) or PPM (P6) image through a memory mapping.
+ * The header is parsed straight from the mapped bytes. A P5 raster is then used in place, so
+ * imageData stays empty and only the pages that are later touched are read from disk.
+ * A P6 raster is converted to grayscale straight from the mapping into imageData, without a
+ * colour copy of the image, and the mapping is released afterwards.
+ * The header is parsed into locals and checked against the size of the mapping first, so a file
+ * that fails any check leaves the previous image, its dimensions and its components as they were.
+ *
+ * @param fileName The file path of the image.
+ * @param isPPM true to read a P6 colour image, false for a P5 grayscale image.
+ * @return true if the file is successfully read; false if otherwise.
+ */
+bool PGMimageProcessor::readMappedPGM(const std::string & fileName, bool isPPM){
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+    if(!file -> open(fileName)){
+        std::cerr << "Failed to open file for read: " << fileName << "\n";
+        return false;
+    }
+    const unsigned char * data = file -> data();
+    size_t size = file -> size();
+
+    //check if valid file/magic number
+    size_t pos = 0;
+    std::string token;
+    nextHeaderToken(data, size, pos, token);
+    if(!isPPM && token != "P5"){
+        std::cerr << "Invalid PGM file: " << fileName << "\n";
+        return false;
+    }else if(isPPM && token != "P6"){
+        std::cerr << "Invalid PPM file: " << fileName << "\n";
+        return false;
+    }
+
+    //read width, height and the max value
+    int header[3] = {0, 0, 0};
+    for(int & value : header){
+        if(!nextHeaderToken(data, size, pos, token)){
+            std::cerr << "Error reading image header!\n";
+            return false;
+        }
+        try{
+            value = std::stoi(token);
+        }catch(const std::exception &){
+            std::cerr << "Invalid header value: " << token << "\n";
+            return false;
+        }
+    }
+    auto [fileWidth, fileHeight, fileMaxVal] = header;
+
+    if (fileWidth <= 0 || fileHeight <= 0) {
+        std::cerr<<"Invalid image dimensions: " << fileWidth << "x" << fileHeight << "\n";
+        return false;
+    }
+
+    if (fileMaxVal != 255) {
+        std::cerr << "Unsupported max value: " << fileMaxVal << "\n";
+        return false;
+    }
+
+    //a single whitespace character separates the header from the raster
+    ++pos;
+    size_t pixelCount = static_cast<size_t>(fileWidth) * fileHeight;
+    size_t rasterSize = isPPM ? pixelCount * 3 : pixelCount;
+    if(pos > size || size - pos < rasterSize){
+        std::cerr << "Error reading image data!\n";
+        return false;
+    }
+
+    //every check passed, so the file replaces the previous image
+    width = fileWidth;
+    height = fileHeight;
+    maxVal = fileMaxVal;
+    histogram.fill(0);
+    histogramValid = false;
+    clearComponents();
+
+    if(!isPPM){
+        //use the raster in place, the histogram is counted when it is first asked for so the pages are not touched here
+        imageData.clear();
+        mappedFile = std::move(file);
+        mappedOffset = pos;
+        return true;
+    }
+
+    //convert the ppm to grayscale straight from the mapping
+    mappedFile.reset();
+    imageData.resize(pixelCount);
+    for(size_t done = 0; done < pixelCount; done += readChunkSize){
+        //I = (77R + 150G + 29B) >> 8, counted a chunk at a time while the grey levels are still in cache
+        size_t chunk = std::min(readChunkSize, pixelCount - done);
+        GreyConverter::convert(data + pos + done*3, imageData.data() + done, chunk);
+        countHistogram(imageData.data() + done, chunk);
+    }
+    histogramValid = true;
+    return true;
+}
+
+/**
+ * Adds a block of grey levels to the histogram.
+ * Neighbouring pixels often have the same grey level, so they are counted into four separate tables
+ * that are summed at the end, which stops each increment from waiting on the one before it.
+ *
+ * @param pixels The grey levels to count.
+ * @param count The number of pixels.
+ */
+void PGMimageProcessor::countHistogram(const unsigned char * pixels, size_t count) const{
+    std::array<std::array<size_t, 256>, 4> partial{};
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        ++partial[0][pixels[i]];
+        ++partial[1][pixels[i + 1]];
+        ++partial[2][pixels[i + 2]];
+        ++partial[3][pixels[i + 3]];
+    }
+    for(; i < count; ++i){
+        ++partial[0][pixels[i]];
+    }
+    for(int level = 0; level < 256; ++level){
+        histogram[level] += partial[0][level] + partial[1][level] + partial[2][level] + partial[3][level];
+    }
+}
+
 //utility methods
 /**
  * Gets the total number of connected components found in the image.
@@ -270,13 +1244,13 @@ int PGMimageProcessor::getComponentCount(void) const{
  * @return The number of pixels in the largest component. Returns 0 if there are no components.
  */
 int PGMimageProcessor::getLargestSize(void) const{
-    int maxSize = 0;
-    for(size_t i = 0; i<components.size(); ++i){
-        if(components[i] -> getSize() > maxSize){
-            maxSize = components[i] -> getSize();
-        }
+    if (components.empty()) {
+        return 0;
+    }
+    if (!sizeIndexValid) {
+        buildSizeIndex();
     }
-    return maxSize;
+    return components[sizeIndex.front()].getSize();
 }
 
 /**
@@ -289,13 +1263,80 @@ int PGMimageProcessor::getSmallestSize(void) const{
         return 0;
     }
 
-    int minSize = components[0] -> getSize();
-    for(size_t i = 0; i<components.size(); ++i){
-        if(components[i] -> getSize() < minSize){
-            minSize = components[i] -> getSize();
-        }
+    if (!sizeIndexValid) {
+        buildSizeIndex();
+    }
+    return components[sizeIndex.back()].getSize();
+}
+
+/**
+ * Sorts the positions of the components from largest to smallest.
+ * The components are in ID order and the sort is stable, so components of the same size stay in ID order.
+ * Building it is not thread safe, so call a size query once before sharing the processor between threads.
+ */
+void PGMimageProcessor::buildSizeIndex() const{
+    sizeIndex.resize(components.size());
+    for(size_t i = 0; i < components.size(); ++i){
+        sizeIndex[i] = i;
+    }
+    std::stable_sort(sizeIndex.begin(), sizeIndex.end(), [this](int a, int b){
+        return components[a].getSize() > components[b].getSize();
+    });
+    sizeIndexValid = true;
+}
+
+/**
+ * Drops the components of the previous image. Called as soon as a new image starts to replace it, since
+ * the label image and size index built from the old components no longer match the new width and height.
+ */
+void PGMimageProcessor::clearComponents(){
+    components.clear();
+    labelImageValid = false;
+    sizeIndexValid = false;
+}
+
+/**
+ * @return a view of the components at positions [first, last) of the size index
+ */
+ComponentView PGMimageProcessor::sizeIndexView(size_t first, size_t last) const{
+    std::span<const int> positions(sizeIndex);
+    return ComponentView(positions.subspan(first, last - first), ComponentLookup{&components});
+}
+
+/**
+ * Finds the components within a size range with two binary searches over the size index.
+ * The components themselves are left as they are, so any number of ranges can be tried
+ * without extracting the components again.
+ *
+ * @param minSize Minimum number of pixels a component should have.
+ * @param maxSize Maximum number of pixels a component should have.
+ * @return A view of the components of [minSize, maxSize] pixels, from largest to smallest.
+ */
+ComponentView PGMimageProcessor::getComponentsBySize(int minSize, int maxSize) const{
+    if(!sizeIndexValid){
+        buildSizeIndex();
+    }
+    if(minSize > maxSize){
+        return sizeIndexView(0, 0);
+    }
+    //the index runs from largest to smallest, so the range starts at the first size <= maxSize
+    auto sizeOf = [this](int position){ return components[position].getSize(); };
+    auto first = std::ranges::lower_bound(sizeIndex, maxSize, std::greater<int>(), sizeOf);
+    auto last = std::ranges::upper_bound(sizeIndex, minSize, std::greater<int>(), sizeOf);
+    return sizeIndexView(first - sizeIndex.begin(), std::max(first, last) - sizeIndex.begin());
+}
+
+/**
+ * Gets the largest components straight from the front of the size index.
+ *
+ * @param count The number of components wanted.
+ * @return A view of at most count components, from largest to smallest.
+ */
+ComponentView PGMimageProcessor::getLargestComponents(int count) const{
+    if(!sizeIndexValid){
+        buildSizeIndex();
     }
-    return minSize;
+    return sizeIndexView(0, std::min(sizeIndex.size(), static_cast<size_t>(std::max(count, 0))));
 }
 
 /**
@@ -308,6 +1349,146 @@ bool PGMimageProcessor::isPPMFile(const std::string & fileName){
     return fileName.substr(fileName.size() - 4) == ".ppm";
 }
 
+/**
+ * Sets the number of strips the union-find engine labels at the same time, and the number of threads that render each band of writeComponents.
+ *
+ * @param count The number of threads to use, 0 uses every hardware thread.
+ */
+void PGMimageProcessor::setThreadCount(int count){
+    if(count <= 0){
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = count;
+}
+
+/**
+ * Frees the scratch buffers kept between calls to extractComponents, for example after a large image
+ * when the images that follow are smaller. The next extraction allocates them again.
+ */
+void PGMimageProcessor::releaseWorkspace(){
+    workspace.release();
+}
+
+/**
+ * Gets the number of threads used by the union-find engine.
+ *
+ * @return The number of labeling threads.
+ */
+int PGMimageProcessor::getThreadCount() const{
+    return threadCount;
+}
+
+/**
+ * Sets how readPGM loads the raster of the following reads.
+ *
+ * @param mode Copy, Map, or Auto (map large regular files only).
+ */
+void PGMimageProcessor::setLoadMode(LoadMode mode){
+    loadMode = mode;
+}
+
+/**
+ * Gets how readPGM loads the raster.
+ *
+ * @return The current load mode.
+ */
+LoadMode PGMimageProcessor::getLoadMode() const{
+    return loadMode;
+}
+
+/**
+ * Checks whether the pixels are a view over a memory mapped file.
+ *
+ * @return true if the image is mapped, false if imageData owns the pixels.
+ */
+bool PGMimageProcessor::isMapped() const{
+    return mappedFile != nullptr;
+}
+
+/**
+ * Gets the grayscale pixels of the image, whichever way they were loaded.
+ *
+ * @return A pointer to width*height pixels in row order.
+ */
+const unsigned char * PGMimageProcessor::getImageData() const{
+    if(mappedFile){
+        return mappedFile -> data() + mappedOffset;
+    }
+    return imageData.data();
+}
+
+/**
+ * Gets the histogram of the current image, counting it first if the image is memory mapped.
+ * Counting a mapped image is not thread safe, so call this once before sharing the processor between threads.
+ *
+ * @return The number of pixels with each grey level.
+ */
+const std::array<size_t, 256> & PGMimageProcessor::getHistogram() const{
+    if(!histogramValid){
+        histogram.fill(0);
+        if(getImageData() != nullptr){
+            countHistogram(getImageData(), static_cast<size_t>(width) * height);
+        }
+        histogramValid = true;
+    }
+    return histogram;
+}
+
+/**
+ * Picks a threshold with Otsu's method - the split of the histogram into two classes
+ * (background below the threshold, foreground at or above it) with the largest between-class variance.
+ * Only the 256 bins are visited, the pixels are not read again.
+ *
+ * @return The threshold, or 128 if the image has a single grey level and cannot be split.
+ */
+unsigned char PGMimageProcessor::getOtsuThreshold() const{
+    const std::array<size_t, 256> & counts = getHistogram();
+    double total = 0, totalSum = 0;
+    for(int level = 0; level < 256; ++level){
+        total += counts[level];
+        totalSum += static_cast<double>(level) * counts[level];
+    }
+
+    int best = 128;
+    double bestVariance = 0;
+    double backgroundCount = 0, backgroundSum = 0;
+    for(int level = 0; level < 255; ++level){
+        //the background is every grey level up to and including level
+        backgroundCount += counts[level];
+        backgroundSum += static_cast<double>(level) * counts[level];
+        double foregroundCount = total - backgroundCount;
+        if(backgroundCount == 0){
+            continue;
+        }
+        if(foregroundCount == 0){
+            break;
+        }
+        double meanDifference = backgroundSum / backgroundCount - (totalSum - backgroundSum) / foregroundCount;
+        double variance = backgroundCount * foregroundCount * meanDifference * meanDifference;
+        if(variance > bestVariance){
+            bestVariance = variance;
+            best = level + 1;
+        }
+    }
+    return static_cast<unsigned char>(best);
+}
+
+/**
+ * Gets the phase counters of this processor.
+ *
+ * @return The time, bytes and pixels of each phase, the peak component count and the peak memory.
+ */
+const ProcessingStats & PGMimageProcessor::getStats() const{
+    return stats;
+}
+
+/**
+ * Clears the phase counters, e.g. before timing a single image.
+ */
+void PGMimageProcessor::resetStats(){
+    stats.reset();
+}
+
 /**
  * Gets the width of the loaded PGM image.
  *
@@ -341,13 +1522,14 @@ void PGMimageProcessor::printComponentData(const ConnectedComponent & theCompone
  * Prints the colourIntensity of each component
  */
 void PGMimageProcessor::printComponentPixelValues() const{
-    for (const auto& component : components) {
-        std::cout << "Component ID: " << component->getID() << "\n";
+    const unsigned char * imageData = getImageData();
+    for (const ConnectedComponent & component : components) {
+        std::cout << "Component ID: " << component.getID() << "\n";
     
         bool printed = false;
         unsigned char visitedValue = 0;
 
-        for (const std::pair<int, int> & pixel : component->getPixels()) {
+        for (const std::pair<int, int> & pixel : component.getPixels()) {
             int x = pixel.first;
             int y = pixel.second;
             int index = y * width + x;
@@ -366,10 +1548,100 @@ void PGMimageProcessor::printComponentPixelValues() const{
 
 
 /**
- * Gets a list of all the connected components found in the image.
+ * Rasterises every component into the label image, a run at a time for run-length components.
+ * The labels are 16-bit unless the largest component ID does not fit.
+ */
+void PGMimageProcessor::buildLabelImage() const{
+    int maxID = -1;
+    for(const ConnectedComponent & component : components){
+        maxID = std::max(maxID, component.getID());
+    }
+    labelImage.reset(width, height, maxID);
+
+    for(const ConnectedComponent & component : components){
+        if(component.isRunLength()){
+            for(const ConnectedComponent::Run & run : component.getRuns()){
+                labelImage.fillRun(run.y, run.xStart, run.xEnd, component.getID());
+            }
+            continue;
+        }
+        for(const std::pair<int, int> & pixel : component.getPixels()){
+            labelImage.set(pixel.first, pixel.second, component.getID());
+        }
+    }
+    labelImageValid = true;
+}
+
+/**
+ * Gets the label image of the current components, building it first if the components have changed.
+ * Building it is not thread safe, so call this once before sharing the processor between threads.
+ *
+ * @return The label image.
+ */
+const LabelImage & PGMimageProcessor::getLabelImage() const{
+    if(!labelImageValid){
+        buildLabelImage();
+    }
+    return labelImage;
+}
+
+/**
+ * Finds the component that contains a pixel with a single lookup in the label image.
+ *
+ * @param x The x coordinate of the pixel.
+ * @param y The y coordinate of the pixel.
+ * @return The ID of the component, or -1 if the pixel is outside the image or not in a component.
+ */
+int PGMimageProcessor::getLabelAt(int x, int y) const{
+    if(x < 0 || x >= width || y < 0 || y >= height){
+        return -1;
+    }
+    return getLabelImage().at(x, y);
+}
+
+/**
+ * Writes the label image to a 16-bit PGM.
+ *
+ * @param outputFileName File name to save the label image (".pgm" is added).
+ * @return True if write is successful, false otherwise.
+ */
+bool PGMimageProcessor::writeLabelImage(const std::string & outputFileName) const{
+    const LabelImage & labels = getLabelImage();
+    ProcessingStats::Timer timer(stats, Phase::Write);
+    if(!labels.writePGM(outputFileName + ".pgm")){
+        return false;
+    }
+    timer.addBytes(static_cast<size_t>(width) * height * 2);
+    timer.addPixels(static_cast<size_t>(width) * height);
+    return true;
+}
+
+/**
+ * Writes the components, their records and their runs to a .ccx file that ComponentFile can map and query.
+ *
+ * @param outputFileName File name to save the components (".ccx" is added).
+ * @return True if write is successful, false otherwise.
+ */
+bool PGMimageProcessor::writeComponentFile(const std::string & outputFileName) const{
+    ProcessingStats::Timer timer(stats, Phase::Write);
+    std::string componentFileName = outputFileName + ".ccx";
+    if(!ComponentFile::write(componentFileName, components, width, height)){
+        return false;
+    }
+    Logger::log(Verbosity::Verbose, "Data successfully written to ", componentFileName);
+    long long bytes = MappedFile::regularFileSize(componentFileName);
+    timer.addBytes(bytes > 0 ? bytes : 0);
+    timer.addPixels(static_cast<size_t>(width) * height);
+    return true;
+}
+
+/**
+ * Gets a view of all the connected components found in the image.
+ * The view does not own or copy the components, and it is invalidated by the next
+ * extractComponents or filterComponentsBySize call.
  *
- * @return A vector containing shared pointers to all connected components.
+ * @return A read-only span over the connected components.
  */
-std::vector< std::shared_ptr<ConnectedComponent> > PGMimageProcessor::getComponents(){
+std::span<const ConnectedComponent> PGMimageProcessor::getComponents() const{
     return components;
 }
\ No newline at end of file
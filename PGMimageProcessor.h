@@ -1,6 +1,53 @@
 #ifndef _PGMIMAGEPROCESSOR_H
 #define _PGMIMAGEPROCESSOR_H
 #include "ConnectedComponent.h"
+#include "UnionFind.h"
+#include "ForegroundBitmap.h"
+#include "MappedFile.h"
+#include "LabelImage.h"
+#include "ProcessingStats.h"
+#include "GreyConverter.h"
+#include "LabelingWorkspace.h"
+#include "ComponentArena.h"
+#include "Logger.h"
+#include "ComponentFile.h"
+#include <thread>
+#include <barrier>
+#include <cstring>
+#include <algorithm>
+#include <span>
+#include <ranges>
+
+/**
+ * Selects the algorithm used by extractComponents to label the foreground pixels.
+ *
+ * BFS - flood fills each component from its first pixel using a queue.
+ * UnionFind - two-pass raster scan with provisional labels that are merged in a union-find forest.
+ * RunLength - raster scan over horizontal runs, components are stored as runs instead of single pixels.
+ */
+enum class LabelingEngine { BFS, UnionFind, RunLength };
+
+/**
+ * Selects how readPGM loads the raster.
+ *
+ * Copy - reads the raster into an owned vector.
+ * Map - memory maps the file, a P5 raster is then used in place without being copied.
+ * Auto - maps regular files of at least PGMimageProcessor::autoMapSize bytes, copies small files and pipes.
+ */
+enum class LoadMode { Auto, Copy, Map };
+
+/**
+ * Turns an index into the component at that position, used to present a list of indices as components
+ */
+struct ComponentLookup{
+    const std::vector<ConnectedComponent> * components;
+    const ConnectedComponent & operator()(int index) const{
+        return (*components)[index];
+    }
+};
+
+//Read-only view of some of the components (in size order), valid until the components are next changed
+typedef std::ranges::transform_view<std::span<const int>, ComponentLookup> ComponentView;
 
 /**
  * PGMimageProcessor class
@@ -17,11 +64,98 @@ class PGMimageProcessor{
     protected:
         int width, height; //dimensions of the image
         int maxVal;
-        std::vector<unsigned char> imageData;
-        std::vector< std::shared_ptr<ConnectedComponent> > components; //list of extracted connected components
+        std::vector<unsigned char> imageData; //owned pixels, empty while the pixels are a view over mappedFile
+        std::shared_ptr<MappedFile> mappedFile; //mapping that backs a zero-copy P5 image (shared between copies of the processor)
+        size_t mappedOffset; //offset of the raster within mappedFile
+        LoadMode loadMode; //how readPGM loads the raster
+        mutable std::array<size_t, 256> histogram; //number of pixels with each grey level
+        mutable bool histogramValid; //false until the histogram of the current image has been counted
+        std::unique_ptr<ComponentArena> arena; //holds the pixel and run lists of the extracted components (declared first so it is destroyed after them)
+        std::vector<ConnectedComponent> components; //list of extracted connected components, stored contiguously
+        mutable LabelImage labelImage; //component ID of every pixel, rasterised from the components when first asked for
+        mutable bool labelImageValid; //false until labelImage matches the current components
+        mutable std::vector<int> sizeIndex; //positions of the components from largest to smallest (ties in ID order)
+        mutable bool sizeIndexValid; //false until sizeIndex matches the current components
         std::string fileName;
+        int threadCount; //number of strips labeled at once by the union-find engine, and of threads rendering each output band
+        mutable ProcessingStats stats; //time, bytes and pixels of each phase, added up over every image until resetStats
+        LabelingWorkspace workspace; //scratch buffers of extractComponents, kept between calls (not copied with the processor)
+
+        /**
+         * Labels the image with a Breadth First Search from each unvisited foreground pixel
+         */
+        int extractComponentsBFS(const ForegroundBitmap & foreground, int minValidSize, int connectivity);
+
+        /**
+         * Labels the image with a two-pass raster scan and an array-based union-find
+         */
+        int extractComponentsUnionFind(const ForegroundBitmap & foreground, int minValidSize, int connectivity);
+
+        /**
+         * Labels horizontal runs of foreground pixels and stores the components run-length encoded
+         */
+        int extractComponentsRunLength(const ForegroundBitmap & foreground, int minValidSize, int connectivity);
+
+        /**
+         * @return true if readPGM should memory map the file under the current load mode
+         */
+        bool shouldMapFile(const std::string & fileName) const;
+
+        /**
+         * Reads a PGM or PPM through a memory mapping, parsing the header in place
+         */
+        bool readMappedPGM(const std::string & fileName, bool isPPM);
+
+        /**
+         * Adds count grey levels to the histogram
+         */
+        void countHistogram(const unsigned char * pixels, size_t count) const;
+
+        /**
+         * Rasterises the current components into the label image
+         */
+        void buildLabelImage() const;
+
+        /**
+         * Sorts the positions of the current components by size into sizeIndex
+         */
+        void buildSizeIndex() const;
+
+        /**
+         * Drops the components of the previous image, with the label image and size index built from them
+         */
+        void clearComponents();
+
+        /**
+         * @return a view of the components at sizeIndex[first, last)
+         */
+        ComponentView sizeIndexView(size_t first, size_t last) const;
+
+        /**
+         * Streams the components to a PGM (1 channel) or PPM (3 channels) file a band of rows at a time
+         */
+        bool writeRaster(const std::string & outputFile, int channels, bool drawBoundingBoxes);
+
+        /**
+         * Renders rows [yBegin, yEnd) of the output into band, from the components in [first, last) whose lists are in row order
+         */
+        void fillBand(unsigned char * band, int yBegin, int yEnd, int channels, bool drawBoundingBoxes, const std::vector<char> & rowOrdered, size_t first, size_t last) const;
+
+        /**
+         * Writes one share of the pixels of the lists that are not in row order into a band rendered by fillBand
+         */
+        void fillUnordered(unsigned char * band, int yBegin, int yEnd, int channels, const std::vector<char> & rowOrdered, size_t first, size_t last, int part, int numParts) const;
 
     public:
+        //files at least this large are memory mapped in LoadMode::Auto
+        static const size_t autoMapSize = 64 * 1024 * 1024;
+
+        //readPGM reads a P5 raster this many bytes at a time, counting each chunk into the histogram while it is in cache
+        static const size_t readChunkSize = 256 * 1024;
+
+        //writeComponents renders and writes about this many bytes of output rows at a time (at least one row)
+        static constexpr size_t writeBandSize = 4 * 1024 * 1024;
+
         //Constructors and Destructir (Big 6)
 
         /**
@@ -61,9 +195,14 @@ class PGMimageProcessor{
         
         //Core method
         /**
-         * Extracts all connected components from a binary image based on the threshold
+         * Replaces the image with a width*height grey level raster, reusing the storage of the current one
+         */
+        bool reset(std::span<const unsigned char> image, int width, int height);
+
+        /**
+         * Extracts all connected components from a binary image based on the threshold, with 4 or 8 connectivity
          */
-        int extractComponents(unsigned char threshold, int minValidSize);
+        int extractComponents(unsigned char threshold, int minValidSize, LabelingEngine engine = LabelingEngine::BFS, int connectivity = 4);
 
         /**
          * Filters components based on the sized constraints
@@ -74,58 +213,22 @@ class PGMimageProcessor{
          * Specialised template for PGM(gray scale) files
          * Writes components to a PGM image.
          * Each component's pixels are colored white (255,255,255).
+         * The image is rendered and written a band of rows at a time, so the whole raster is never held in memory.
          *
          * @tparam T Unused (kept for template specialization purposes).
          * @param outputFileName File name to save the PPM image.
          * @return True if write is successful, false otherwise.
          */
         template <typename T> bool writeComponents(const std::string & outputFileName){
-            std::string outputFile = outputFileName +".pgm";
-            std::ofstream out(outputFile, std::ios::binary);
-            if(!out){
-                std::cerr << "Error: Unable to write file " << outputFile << "\n";
-                return false;
-            }
-        
-            //Initialise output image data
-            std::vector<unsigned char> outputImageData(width*height, 0);
-        
-            //PGM header
-            out << "P5" << std::endl << width << " " << height << std::endl << 255 << std::endl;
-        
-            //process components and sets their pixels to white(255)
-            for(size_t i = 0; i<components.size(); ++i){
-                std::vector< std::pair<int, int> > pixels = components[i] ->getPixels();
-                for(size_t j = 0; j< pixels.size(); ++j){
-                    int x = pixels[j].first;
-                    int y = pixels[j].second;
-                    
-                    //outputImageData[y*width+x] = 255;
-                    if(x >= 0 && x < width && y >= 0 && y < height) {
-                        outputImageData[y*width+x] = 255;
-                    }
-                }
-            }
-        
-            //write to the file
-            out.write(reinterpret_cast<char *>(outputImageData.data()), outputImageData.size());
-            std::cout << "Data successfully written to file" <<std::endl;
-            
-            if (!out || out.fail())
-            {
-                std::cerr << "Error writing binary block of PGM.\n";
-                return false;
-            }
-        
-            out.close();
-            return true;
+            return writeRaster(outputFileName + ".pgm", 1, false);
         }
-        
+
         /**
          * Specialised template for PPM(colour) files with optional bounding boxes
          * Writes components to a PPM (colour) image.
          * Each component's pixels are coloured white (255,255,255).
          * If drawBoundingBoxes is true, then red rectangles are drawn around each component.
+         * The image is rendered and written a band of rows at a time, so the whole raster is never held in memory.
          * 
          * @tparam T Unused (kept for template specialization purposes).
          * @tparam drawBoundingBoxes to check if red bounding boxes should be drawn on the components of the output image.
@@ -133,155 +236,130 @@ class PGMimageProcessor{
          * @return True if write is successful, false otherwise.
          */
         template <typename T, bool drawBoundingBoxes> bool writeComponents(const std::string & outputFileName){
-            std::string outputFile = outputFileName + ".ppm";
-            std::ofstream out(outputFile, std::ios::binary);
-            if(!out){
-                std::cerr << "Error: Unable to write file " << outputFile << "\n";
-                return false;
-            }
-        
-            //initialise the colour image data
-            std::vector<unsigned char> outputImageData;
-        
-            //PPM header
-            out << "P6" << std::endl << width << " " << height << std::endl << 255 << std::endl;
-            outputImageData.resize(width*height*3, 0);
-        
-            //if drawing bpunding boxes, start with original image converted to colour
-            if(drawBoundingBoxes){
-                //convert original grayscale to colour
-                for(int y = 0; y<height; ++y){
-                    for(int x = 0; x<width; ++x){
-                        int index = y*width+x;
-                        unsigned char grayValue = imageData[index];
-                        outputImageData[index * 3] = grayValue;     // R
-                        outputImageData[index * 3 + 1] = grayValue; // G
-                        outputImageData[index * 3 + 2] = grayValue; // B
-                    }
-                }
-            }
-            
-            //process components and set their pixels to white
-            for(size_t i = 0; i<components.size(); ++i){
-                std::vector< std::pair<int, int> > pixels = components[i] ->getPixels();
-                for(size_t j = 0; j< pixels.size(); ++j){
-                    int x = pixels[j].first;
-                    int y = pixels[j].second;
-        
-                    if(x >= 0 && x < width && y >= 0 && y < height){
-                        int index = y*width+x;
-                        if(!drawBoundingBoxes){
-                            //set to white if not drawing bounding boxes
-                            outputImageData[index * 3] = 255;
-                            outputImageData[index * 3 + 1] = 255;
-                            outputImageData[index * 3 + 2] = 255;
-                        }
-                    }
-                }
-            }
-        
-            if(drawBoundingBoxes) {
-            //draw bounding boxes if requested and its a PPM image
-                for(size_t i = 0; i<components.size(); ++i){
-                    std::tuple<int, int, int, int> boundingBox = components[i] -> getBoundingBox();
-                    int x_min = std::get<0>(boundingBox);
-                    int y_min = std::get<1>(boundingBox);
-                    int x_max = std::get<2>(boundingBox);
-                    int y_max = std::get<3>(boundingBox);
-        
-        
-                    // Add bounds checking to ensure values are within image dimensions
-                    x_min = std::max(0, std::min(x_min, width-1));
-                    y_min = std::max(0, std::min(y_min, height-1));
-                    x_max = std::max(0, std::min(x_max, width-1));
-                    y_max = std::max(0, std::min(y_max, height-1));
-        
-                    // Also ensure min <= max
-                    if (x_min > x_max) std::swap(x_min, x_max);
-                    if (y_min > y_max) std::swap(y_min, y_max);
-                    
-                    std::cout << "Component " << i << " bounding box: " << "Xmin: " << x_min << ", Xmax: " << x_max << ", Ymin: " << y_min << ", Ymax: " << y_max << std::endl;
-        
-                    //draw horizontal bounding box lines (top and bottom)
-                    for(int x = x_min; x <= x_max; ++x){
-                        //top horizontal line
-                        int topIndex = (y_min * width + x) * 3;
-                        int bottomIndex = (y_max * width + x) * 3;
-        
-                        if (topIndex >= 0 && topIndex < static_cast<int>(outputImageData.size()-2)) {
-                            outputImageData[topIndex] = 255;
-                            outputImageData[topIndex + 1] = 0;
-                            outputImageData[topIndex + 2] = 0;
-                        }
-        
-                        if (bottomIndex >= 0 && bottomIndex < static_cast<int>(outputImageData.size()-2)) {
-                            outputImageData[bottomIndex] = 255;
-                            outputImageData[bottomIndex + 1] = 0;
-                            outputImageData[bottomIndex + 2] = 0;
-                        }
-                    }
-        
-                    //draw vertical bounding box lines (left and right)
-                    for(int y = y_min +1; y < y_max; ++y){
-                        //left vertical line
-                        int leftIndex = (y * width + x_min) * 3;
-                        int rightIndex = (y * width + x_max) * 3;
-                        if (leftIndex >= 0 && leftIndex < static_cast<int>(outputImageData.size()-2)) {
-                            outputImageData[leftIndex] = 255;     // Red
-                            outputImageData[leftIndex + 1] = 0;   // Green
-                            outputImageData[leftIndex + 2] = 0;   // Blue
-                        }
-        
-                        //right vertical line
-                        if (rightIndex >= 0 && rightIndex < static_cast<int>(outputImageData.size()-2)) {
-                            outputImageData[rightIndex] = 255;     // Red
-                            outputImageData[rightIndex + 1] = 0;   // Green
-                            outputImageData[rightIndex + 2] = 0;   // Blue
-                        }
-                    }
-                }
-            }
-        
-            out.write(reinterpret_cast<char *>(outputImageData.data()), outputImageData.size());
-            std::cout << "Data successfully written to file" <<std::endl;
-            
-            if (!out)
-            {
-                std::cerr << "Error writing binary block of PGM.\n";
-                return false;
-            }
-        
-            if (!out || out.fail())
-            {
-                std::cerr << "Error writing binary block of PPM.\n";
-                return false;
-            }
-        
-            out.close();
-            return true;
-        }        
-        
+            return writeRaster(outputFileName + ".ppm", 3, drawBoundingBoxes);
+        }
+
         //utility methods
         /**
-         * @return the number of components currently saved
+         * @return a read-only view of the components currently saved, valid until the components are next changed
          */
-        std::vector< std::shared_ptr<ConnectedComponent> > getComponents();
+        std::span<const ConnectedComponent> getComponents() const;
         
+        /**
+         * Returns the per-pixel labels of the current components (ID + 1, 0 for no component).
+         * The label image is built from the components the first time it is asked for after
+         * extractComponents or filterComponentsBySize, and then kept.
+         * @return the label image
+         */
+        const LabelImage & getLabelImage() const;
+
+        /**
+         * @return the ID of the component that contains pixel (x, y), or -1 if there is none
+         */
+        int getLabelAt(int x, int y) const;
+
+        /**
+         * Writes the label image as a 16-bit PGM (maxVal 65535) named outputFileName + ".pgm"
+         * @return true if the file was written
+         */
+        bool writeLabelImage(const std::string & outputFileName) const;
+
+        /**
+         * Writes the components to a binary component file named outputFileName + ".ccx" (see ComponentFile)
+         * @return true if the file was written
+         */
+        bool writeComponentFile(const std::string & outputFileName) const;
+
         /**
          * @return the number of conponents currently saved
          */
         int getComponentCount(void) const;
 
         /**
-         * @return the size of the largest component
+         * @return the size of the largest component (O(1) once the size index is built)
          */
         int getLargestSize(void) const;
 
         /**
-         * @return the size of the smallest component
+         * @return the size of the smallest component (O(1) once the size index is built)
          */
         int getSmallestSize(void) const;
 
+        /**
+         * Finds the components whose size is between [minSize, maxSize] without removing any, unlike filterComponentsBySize.
+         * The components are sorted by size once, the first time the index is needed after extractComponents or
+         * filterComponentsBySize, and every later query is two binary searches.
+         * @return a view of the matching components from largest to smallest
+         */
+        ComponentView getComponentsBySize(int minSize, int maxSize) const;
+
+        /**
+         * @return a view of the count largest components from largest to smallest (all of them if there are fewer)
+         */
+        ComponentView getLargestComponents(int count) const;
+
+        /**
+         * Sets the number of threads used by the union-find engine (the BFS engine always runs on one thread) and by writeComponents.
+         * A count of 0 uses every hardware thread.
+         */
+        void setThreadCount(int count);
+
+        /**
+         * Frees the scratch buffers kept between calls to extractComponents
+         */
+        void releaseWorkspace();
+
+        /**
+         * @return the number of threads used by the union-find engine
+         */
+        int getThreadCount() const;
+
+        /**
+         * Sets how readPGM loads the raster (LoadMode::Auto by default)
+         */
+        void setLoadMode(LoadMode mode);
+
+        /**
+         * @return how readPGM loads the raster
+         */
+        LoadMode getLoadMode() const;
+
+        /**
+         * @return true if the pixels are a view over a memory mapped file rather than an owned copy
+         */
+        bool isMapped() const;
+
+        /**
+         * @return a pointer to the width*height grayscale pixels, whether they are owned or mapped
+         */
+        const unsigned char * getImageData() const;
+
+        /**
+         * Returns the number of pixels with each grey level (0 to 255) of the current image.
+         * The histogram is counted while readPGM reads the raster, so this does not rescan the pixels.
+         * A memory mapped PGM is never read by readPGM, so its histogram is counted on the first call.
+         * @return the 256-bin histogram of the image
+         */
+        const std::array<size_t, 256> & getHistogram() const;
+
+        /**
+         * Picks the threshold that best splits the histogram into background and foreground (Otsu's method).
+         * @return the threshold to pass to extractComponents
+         */
+        unsigned char getOtsuThreshold() const;
+
+        /**
+         * Gets the time, bytes and pixels of each phase (read, threshold, label, filter and write),
+         * added up over every image processed since the processor was made or resetStats was called.
+         * @return the phase counters
+         */
+        const ProcessingStats & getStats() const;
+
+        /**
+         * Clears the phase counters
+         */
+        void resetStats();
+
         /**
          * @return the width of the image
          */
@@ -308,91 +386,108 @@ class PGMimageProcessor{
          */
         bool isPPMFile(const std::string & fileName);
 
+        /**
+         * Reads the header of a PGM/PPM stream (magic number, width, height and max value), skipping comments,
+         * and leaves the stream at the first byte of the raster.
+         * @return true if all four fields were read
+         */
+        static bool readHeader(std::istream & in, std::string & magicNumber, int & width, int & height, int & maxVal);
+
         /**
         * Reads a PGM (Portable Gray Map) image from a file.
         * This method opens a PGM file in "P5" (pgm file) or "P6" (ppm file) format, and then extracts the image's width, height, and max value, and stores the grayscale pixel data in imageData.
         * It ensures the image is valid, handles comments in the header, and checks for errors during parsing or I/O.
+        * Depending on the load mode, large regular files are memory mapped instead (see readMappedPGM).
         * @param inputImageName The file path to the PGM image to be read.
         * @return true if the file is successfully read and image data is loaded; false if otherwise. 
         */
         template <bool isPPM = false> bool readPGM(const std::string &fileName){
+            ProcessingStats::Timer timer(stats, Phase::Read);
+            if(shouldMapFile(fileName)){
+                if(!readMappedPGM(fileName, isPPM)){
+                    return false;
+                }
+                size_t pixelCount = static_cast<size_t>(width) * height;
+                timer.addBytes(isPPM ? pixelCount * 3 : pixelCount);
+                timer.addPixels(pixelCount);
+                return true;
+            }
+            mappedFile.reset();
+
             std::ifstream in(fileName, std::ios::binary);
             if(!in){
-                std::cerr << "Failed to open file for read: " << fileName << std::endl;
+                std::cerr << "Failed to open file for read: " << fileName << "\n";
                 return false;
             }
+            histogram.fill(0);
+            histogramValid = false;
+            clearComponents();
         
-            //check if valid file/magic number
+            //check if valid file/magic number and read width, height and the max value
             std::string magicNumber;
-            in >> magicNumber;
+            if(!readHeader(in, magicNumber, width, height, maxVal)){
+                std::cerr << "Error reading image header: " << fileName << "\n";
+                return false;
+            }
 
             if(!isPPM && magicNumber != "P5"){
-                    std::cerr << "Invalid PGM file: " << fileName << std::endl;
+                    std::cerr << "Invalid PGM file: " << fileName << "\n";
                     return false;
             } else if ( isPPM && magicNumber != "P6"){
-                    std::cerr << "Invalid PPM file: " << fileName << std::endl;
+                    std::cerr << "Invalid PPM file: " << fileName << "\n";
                     return false;
             }
-        
-            //Skip the comments
-            char ch;
-            while(in>>ch){
-                if(ch == '#'){
-                    in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-                }else{
-                    in.putback(ch);
-                    break;
-                }
-            }
-        
-            //read width, height and the max value
-            in >> width >> height >>maxVal;
+
             if (width <= 0 || height <= 0) {
-                std::cerr<<"Invalid image dimensions: " << width << "x" << height << std::endl;
+                std::cerr<<"Invalid image dimensions: " << width << "x" << height << "\n";
                 return false;
             }
         
             if (maxVal != 255) {
-                std::cerr << "Unsupported max value: " << maxVal << std::endl;
+                std::cerr << "Unsupported max value: " << maxVal << "\n";
                 return false;
             }
-        
-            //consume the newline character after the header
-            in.get();
 
             imageData.resize(width*height);
 
             if(!isPPM){
-                //read a gray scale image
-                in.read(reinterpret_cast<char *>(imageData.data()), width * height);
-            }else{
-                //read colour image (3 bytes per pixel)
-                std::vector<std::array<unsigned char, 3>> colourData(width * height);
-                in.read(reinterpret_cast<char *>(colourData.data()), width * height * 3);
-                
-                //ensure full read
-                if (!in) {
-                    std::cerr << "Error reading PPM image data!" << std::endl;
-                    return false;
+                //read a gray scale image a chunk at a time, counting each chunk while it is still in cache
+                size_t pixelCount = imageData.size();
+                for(size_t done = 0; done < pixelCount && in; done += readChunkSize){
+                    size_t chunk = std::min(readChunkSize, pixelCount - done);
+                    in.read(reinterpret_cast<char *>(imageData.data() + done), chunk);
+                    countHistogram(imageData.data() + done, static_cast<size_t>(in.gcount()));
                 }
-        
-                //convert the ppm to grayscale and store in imageData
-                for (size_t i = 0; i< width*height; ++i){
-                    //I = 0.299 ∗ R + 0.587 ∗ G + 0.114 ∗ B, where (R, G, B) are the channel intensities for your colour pixel.
-                    imageData[i] = static_cast<unsigned char>( 
-                        0.299 * colourData[i][0] 
-                        + 0.587 * colourData[i][1] 
-                        + 0.114 * colourData[i][2]
-                    );
+            }else{
+                //read colour image (3 bytes per pixel) a chunk at a time, converting each chunk to grayscale
+                //straight into imageData so only one chunk of colour pixels is ever held
+                size_t pixelCount = imageData.size();
+                std::vector<unsigned char> colourChunk(std::min(readChunkSize, pixelCount) * 3);
+                for(size_t done = 0; done < pixelCount; done += readChunkSize){
+                    size_t chunk = std::min(readChunkSize, pixelCount - done);
+                    in.read(reinterpret_cast<char *>(colourChunk.data()), chunk * 3);
+
+                    //ensure full read
+                    if (!in) {
+                        std::cerr << "Error reading PPM image data!" << "\n";
+                        return false;
+                    }
+
+                    //I = (77R + 150G + 29B) >> 8, within 1 of 0.299R + 0.587G + 0.114B (see GreyConverter)
+                    GreyConverter::convert(colourChunk.data(), imageData.data() + done, chunk);
+                    countHistogram(imageData.data() + done, chunk);
                 }
             }
             
             //ensure that the data was fully read
             if (!in) {
-                std::cerr << "Error reading image data!" << std::endl;
+                std::cerr << "Error reading image data!" << "\n";
                 return false;
             }
         
+            histogramValid = true;
+            timer.addBytes(isPPM ? imageData.size() * 3 : imageData.size());
+            timer.addPixels(imageData.size());
             return true;
         }
         
@@ -0,0 +1,129 @@
+/**
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "ProcessingStats.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <iomanip>
+
+/**
+ * Adds one run of a phase.
+ *
+ * @param phase The phase that ran.
+ * @param seconds Its wall time.
+ * @param bytes The bytes it read or wrote.
+ * @param pixels The pixels it processed.
+ */
+void ProcessingStats::record(Phase phase, double seconds, uint64_t bytes, uint64_t pixels){
+    PhaseStats & totals = phases[static_cast<int>(phase)];
+    totals.calls++;
+    totals.seconds += seconds;
+    totals.bytes += bytes;
+    totals.pixels += pixels;
+}
+
+/**
+ * Raises the peak component count.
+ */
+void ProcessingStats::notePeakComponents(size_t count){
+    peakComponents = std::max(peakComponents, count);
+}
+
+/**
+ * Adds another set of counters to these, the peaks are combined with max.
+ */
+void ProcessingStats::merge(const ProcessingStats & other){
+    for(int i = 0; i < phaseCount; ++i){
+        phases[i].calls += other.phases[i].calls;
+        phases[i].seconds += other.phases[i].seconds;
+        phases[i].bytes += other.phases[i].bytes;
+        phases[i].pixels += other.phases[i].pixels;
+    }
+    peakComponents = std::max(peakComponents, other.peakComponents);
+}
+
+/**
+ * Clears every counter.
+ */
+void ProcessingStats::reset(){
+    phases = {};
+    peakComponents = 0;
+}
+
+/**
+ * @return the totals of one phase
+ */
+const PhaseStats & ProcessingStats::getPhase(Phase phase) const{
+    return phases[static_cast<int>(phase)];
+}
+
+/**
+ * @return the most components held at once
+ */
+size_t ProcessingStats::getPeakComponents() const{
+    return peakComponents;
+}
+
+/**
+ * Reads the peak resident set size of the process from getrusage (reported in KiB on Linux).
+ *
+ * @return the peak memory in KiB, or -1 if it could not be read
+ */
+long ProcessingStats::getPeakMemoryKiB(){
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0){
+        return -1;
+    }
+    return usage.ru_maxrss;
+}
+
+/**
+ * @return the lower case name of a phase, used as its JSON key
+ */
+const char * ProcessingStats::phaseName(Phase phase){
+    switch(phase){
+        case Phase::Read:
+            return "read";
+        case Phase::Threshold:
+            return "threshold";
+        case Phase::Label:
+            return "label";
+        case Phase::Filter:
+            return "filter";
+        default:
+            return "write";
+    }
+}
+
+/**
+ * Writes the counters as one JSON object:
+ * {"phases": {"read": {"calls": 1, "seconds": 0.01, "bytes": 100, "pixels": 100, "mpixels_per_second": 10.0}, ...},
+ *  "peak_components": 8, "peak_memory_kib": 5000}
+ *
+ * @param out The stream to write to.
+ */
+void ProcessingStats::writeJSON(std::ostream & out) const{
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(6);
+
+    out << "{\"phases\": {";
+    for(int i = 0; i < phaseCount; ++i){
+        const PhaseStats & totals = phases[i];
+        double mpixelsPerSecond = totals.seconds > 0 ? totals.pixels / totals.seconds / 1e6 : 0;
+        out << (i == 0 ? "" : ", ") << "\"" << phaseName(static_cast<Phase>(i)) << "\": {"
+            << "\"calls\": " << totals.calls
+            << ", \"seconds\": " << totals.seconds
+            << ", \"bytes\": " << totals.bytes
+            << ", \"pixels\": " << totals.pixels
+            << ", \"mpixels_per_second\": " << mpixelsPerSecond << "}";
+    }
+    out << "}, \"peak_components\": " << peakComponents
+        << ", \"peak_memory_kib\": " << getPeakMemoryKiB() << "}";
+
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,119 @@
+#ifndef _PROCESSINGSTATS_H
+#define _PROCESSINGSTATS_H
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+/**
+ * The phases of processing an image that are timed.
+ *
+ * Read - decoding (or mapping) the file.
+ * Threshold - building the foreground bitmap.
+ * Label - labeling the foreground into components.
+ * Filter - filterComponentsBySize.
+ * Write - writing output images.
+ */
+enum class Phase { Read, Threshold, Label, Filter, Write };
+
+/**
+ * Totals of one phase over every time it ran
+ */
+struct PhaseStats{
+    uint64_t calls = 0;
+    double seconds = 0; //wall time
+    uint64_t bytes = 0; //bytes read or written
+    uint64_t pixels = 0; //pixels processed
+};
+
+/**
+ * ProcessingStats class
+ *
+ * Counters for the phases of PGMimageProcessor: wall time, bytes and pixels per phase,
+ * the most components held at once, and the peak memory of the process.
+ * A Timer records a phase when it goes out of scope, so every return path of a phase is counted.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+class ProcessingStats{
+    public:
+        static const int phaseCount = 5;
+
+        /**
+         * Times one run of a phase from construction to destruction
+         */
+        class Timer{
+            private:
+                ProcessingStats & stats;
+                Phase phase;
+                std::chrono::steady_clock::time_point start;
+                uint64_t bytes = 0, pixels = 0;
+
+            public:
+                Timer(ProcessingStats & stats, Phase phase): stats(stats), phase(phase), start(std::chrono::steady_clock::now()){}
+                ~Timer(){
+                    stats.record(phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), bytes, pixels);
+                }
+                Timer(const Timer &) = delete;
+                Timer & operator=(const Timer &) = delete;
+
+                //Adds to the bytes and pixels processed by this run
+                void addBytes(uint64_t count){ bytes += count; }
+                void addPixels(uint64_t count){ pixels += count; }
+        };
+
+    private:
+        std::array<PhaseStats, phaseCount> phases;
+        size_t peakComponents = 0; //most components held after a phase
+
+    public:
+        /**
+         * Adds one run of a phase
+         */
+        void record(Phase phase, double seconds, uint64_t bytes, uint64_t pixels);
+
+        /**
+         * Raises the peak component count if count is higher
+         */
+        void notePeakComponents(size_t count);
+
+        /**
+         * Adds the counters of another set of stats (e.g. from another thread's processor)
+         */
+        void merge(const ProcessingStats & other);
+
+        /**
+         * Clears every counter
+         */
+        void reset();
+
+        /**
+         * @return the totals of one phase
+         */
+        const PhaseStats & getPhase(Phase phase) const;
+
+        /**
+         * @return the most components held at once
+         */
+        size_t getPeakComponents() const;
+
+        /**
+         * @return the peak resident memory of the whole process in KiB, or -1 if it is not available
+         */
+        static long getPeakMemoryKiB();
+
+        /**
+         * @return the lower case name of a phase
+         */
+        static const char * phaseName(Phase phase);
+
+        /**
+         * Writes the counters as a single JSON object
+         */
+        void writeJSON(std::ostream & out) const;
+};
+
+#endif
@@ -0,0 +1,379 @@
+/**
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+
+#include "StreamingExtractor.h"
+#include "PGMimageProcessor.h"
+#include "GreyConverter.h"
+
+/**
+ * Constructor
+ *
+ * @param bandRows The number of rows to read from the file at a time.
+ */
+StreamingExtractor::StreamingExtractor(int bandRows):
+    bandRows(std::max(1, bandRows)),
+    connectivity(4),
+    width(0),
+    height(0),
+    peakOpenComponents(0),
+    keepRuns(true),
+    openRunCount(0),
+    peakOpenRuns(0),
+    openCount(0)
+{}
+
+/**
+ * Sets the number of rows read from the file at a time.
+ * Larger bands mean fewer reads, smaller bands mean less memory.
+ */
+void StreamingExtractor::setBandRows(int rows){
+    bandRows = std::max(1, rows);
+}
+
+/**
+ * @return the number of rows read from the file at a time
+ */
+int StreamingExtractor::getBandRows() const{
+    return bandRows;
+}
+
+/**
+ * Sets whether components are emitted with their runs. Without them only the size, bounding box and sums of
+ * each open component are kept, so a component that covers the whole image costs no more than a small one.
+ *
+ * @param keep false to emit summaries of the components.
+ */
+void StreamingExtractor::setKeepRuns(bool keep){
+    keepRuns = keep;
+}
+
+/**
+ * @return true if components are emitted with their runs
+ */
+bool StreamingExtractor::getKeepRuns() const{
+    return keepRuns;
+}
+
+/**
+ * Sets whether pixels also connect through their corners.
+ *
+ * @param connectivity 4 or 8, anything else is ignored.
+ */
+void StreamingExtractor::setConnectivity(int connectivity){
+    if(connectivity != 4 && connectivity != 8){
+        std::cerr << "Unsupported connectivity: " << connectivity << " (must be 4 or 8)" << "\n";
+        return;
+    }
+    this->connectivity = connectivity;
+}
+
+/**
+ * @return the connectivity, 4 or 8
+ */
+int StreamingExtractor::getConnectivity() const{
+    return connectivity;
+}
+
+/**
+ * Starts a new open component in a free slot.
+ *
+ * @return The slot of the new component.
+ */
+int StreamingExtractor::newSlot(){
+    int slot;
+    if(!freeSlots.empty()){
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }else{
+        slot = openRuns.size();
+        openRuns.emplace_back();
+        openSizes.push_back(0);
+        openStatistics.emplace_back();
+        openBoxes.emplace_back();
+        lastRow.push_back(-1);
+        parent.push_back(slot);
+    }
+    parent[slot] = slot;
+    openRuns[slot].clear();
+    openSizes[slot] = 0;
+    openStatistics[slot] = ConnectedComponent::Statistics();
+    openBoxes[slot] = {std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
+    lastRow[slot] = -1;
+
+    openCount++;
+    peakOpenComponents = std::max(peakOpenComponents, openCount);
+    return slot;
+}
+
+/**
+ * Finds the slot that a (possibly merged) slot's component now lives in, compressing the path.
+ */
+int StreamingExtractor::findSlot(int slot){
+    int root = slot;
+    while(parent[root] != root){
+        root = parent[root];
+    }
+    while(parent[slot] != root){
+        int next = parent[slot];
+        parent[slot] = root;
+        slot = next;
+    }
+    return root;
+}
+
+/**
+ * Merges two open components, moving the runs of the smaller one into the larger one.
+ * The emptied slot is released once the current row is finished, since runs on the
+ * previous row may still point at it.
+ *
+ * @return The slot of the merged component.
+ */
+int StreamingExtractor::mergeSlots(int a, int b){
+    a = findSlot(a);
+    b = findSlot(b);
+    if(a == b){
+        return a;
+    }
+    if(openRuns[a].size() < openRuns[b].size()){
+        std::swap(a, b);
+    }
+
+    openRuns[a].insert(openRuns[a].end(), openRuns[b].begin(), openRuns[b].end());
+    openSizes[a] += openSizes[b];
+    openStatistics[a].merge(openStatistics[b]);
+    auto & [xMinA, yMinA, xMaxA, yMaxA] = openBoxes[a];
+    auto [xMinB, yMinB, xMaxB, yMaxB] = openBoxes[b];
+    xMinA = std::min(xMinA, xMinB);
+    yMinA = std::min(yMinA, yMinB);
+    xMaxA = std::max(xMaxA, xMaxB);
+    yMaxA = std::max(yMaxA, yMaxB);
+    lastRow[a] = std::max(lastRow[a], lastRow[b]);
+
+    openRuns[b].clear();
+    openRuns[b].shrink_to_fit();
+    parent[b] = a;
+    releasedSlots.push_back(b);
+    openCount--;
+    return a;
+}
+
+/**
+ * Splits one row of the band into runs and attaches each run to the components of the runs
+ * it touches on the previous row, merging them if it touches more than one.
+ *
+ * @param band The thresholded band.
+ * @param bandRow The row within the band.
+ * @param y The row within the image.
+ * @param rowPixels The grey levels of the row.
+ */
+void StreamingExtractor::labelRow(const ForegroundBitmap & band, int bandRow, int y, const unsigned char * rowPixels){
+    currentRuns.clear();
+    size_t above = 0; //first run above that can still touch a run on this row
+    int reach = (connectivity == 8) ? 1 : 0; //runs touch diagonally with 8-connectivity
+
+    int x = 0;
+    while(x < width){
+        int xStart = band.nextForeground(bandRow, x);
+        if(xStart == width){
+            break;
+        }
+        x = band.nextBackground(bandRow, xStart);
+        int xEnd = x - 1;
+
+        while(above < previousRuns.size() && previousRuns[above].xEnd < xStart - reach){
+            ++above;
+        }
+
+        int slot = -1;
+        for(size_t p = above; p < previousRuns.size() && previousRuns[p].xStart <= xEnd + reach; ++p){
+            int touching = findSlot(previousRuns[p].slot);
+            slot = (slot < 0) ? touching : mergeSlots(slot, touching);
+        }
+        if(slot < 0){
+            slot = newSlot();
+        }
+
+        if(keepRuns){
+            openRuns[slot].push_back({y, xStart, xEnd});
+            openRunCount++;
+            peakOpenRuns = std::max(peakOpenRuns, openRunCount);
+        }
+        auto & [xMin, yMin, xMax, yMax] = openBoxes[slot];
+        xMin = std::min(xMin, xStart);
+        yMin = std::min(yMin, y);
+        xMax = std::max(xMax, xEnd);
+        yMax = std::max(yMax, y);
+        openSizes[slot] += xEnd - xStart + 1;
+        openStatistics[slot].addRun(y, xStart, xEnd);
+        openStatistics[slot].addIntensities(rowPixels + xStart, xEnd - xStart + 1);
+        lastRow[slot] = y;
+        currentRuns.push_back({xStart, xEnd, slot});
+    }
+}
+
+/**
+ * Finishes every component that had a run on the previous row but none on row y,
+ * since nothing below can touch it any more.
+ *
+ * @param y The row that was just labeled (height once the whole image is labeled).
+ */
+void StreamingExtractor::finishRow(int y, int minValidSize, int & emitted, const ComponentCallback & callback){
+    for(LabeledRun & run : currentRuns){
+        run.slot = findSlot(run.slot);
+    }
+
+    for(const LabeledRun & run : previousRuns){
+        int slot = findSlot(run.slot);
+        if(lastRow[slot] != y && lastRow[slot] != -2){
+            emit(slot, minValidSize, emitted, callback);
+        }
+    }
+
+    //nothing points at the merged and finished slots any more
+    freeSlots.insert(freeSlots.end(), releasedSlots.begin(), releasedSlots.end());
+    releasedSlots.clear();
+    std::swap(previousRuns, currentRuns);
+}
+
+/**
+ * Hands a finished component to the callback if it is big enough, and releases its slot.
+ */
+void StreamingExtractor::emit(int slot, int minValidSize, int & emitted, const ComponentCallback & callback){
+    openRunCount -= openRuns[slot].size();
+    if(openSizes[slot] >= minValidSize && keepRuns){
+        callback(ConnectedComponent(emitted++, std::move(openRuns[slot]), openStatistics[slot]));
+    }else if(openSizes[slot] >= minValidSize){
+        callback(ConnectedComponent(emitted++, openSizes[slot], openBoxes[slot], openStatistics[slot]));
+    }
+    openRuns[slot] = ConnectedComponent::RunList();
+    lastRow[slot] = -2;
+    releasedSlots.push_back(slot);
+    openCount--;
+}
+
+/**
+ * Extracts the components of a PGM (P5) or PPM (P6) stream band by band.
+ * PPM pixels are converted to grayscale with the same weights as PGMimageProcessor::readPGM.
+ *
+ * @param in The stream, positioned at the start of the file.
+ * @param threshold Pixels >= threshold are foreground.
+ * @param minValidSize The minimum number of pixels a component must have to be emitted.
+ * @param callback Receives each finished component.
+ * @return The number of components emitted, or -1 if the stream is not a valid image.
+ */
+int StreamingExtractor::extract(std::istream & in, unsigned char threshold, int minValidSize, const ComponentCallback & callback){
+    std::string magicNumber;
+    int maxVal;
+    if(!PGMimageProcessor::readHeader(in, magicNumber, width, height, maxVal)){
+        std::cerr << "Error reading image header" << "\n";
+        return -1;
+    }
+    if(magicNumber != "P5" && magicNumber != "P6"){
+        std::cerr << "Invalid PGM/PPM file: " << magicNumber << "\n";
+        return -1;
+    }
+    if (width <= 0 || height <= 0) {
+        std::cerr<<"Invalid image dimensions: " << width << "x" << height << "\n";
+        return -1;
+    }
+    if (maxVal != 255) {
+        std::cerr << "Unsupported max value: " << maxVal << "\n";
+        return -1;
+    }
+    bool isPPM = magicNumber == "P6";
+
+    //reset the per-image state, keeping the storage
+    openRuns.clear();
+    openSizes.clear();
+    openStatistics.clear();
+    openBoxes.clear();
+    lastRow.clear();
+    parent.clear();
+    freeSlots.clear();
+    releasedSlots.clear();
+    previousRuns.clear();
+    currentRuns.clear();
+    openCount = 0;
+    peakOpenComponents = 0;
+    openRunCount = 0;
+    peakOpenRuns = 0;
+
+    int rowsPerBand = std::min(bandRows, height);
+    std::vector<unsigned char> band(static_cast<size_t>(rowsPerBand) * width);
+    std::vector<unsigned char> colourBand(isPPM ? band.size() * 3 : 0);
+    ForegroundBitmap bitmap;
+    int emitted = 0;
+
+    for(int bandStart = 0; bandStart < height; bandStart += rowsPerBand){
+        int rows = std::min(rowsPerBand, height - bandStart);
+        size_t pixelCount = static_cast<size_t>(rows) * width;
+
+        if(!isPPM){
+            in.read(reinterpret_cast<char *>(band.data()), pixelCount);
+        }else{
+            in.read(reinterpret_cast<char *>(colourBand.data()), pixelCount * 3);
+            GreyConverter::convert(colourBand.data(), band.data(), pixelCount);
+        }
+        if(!in){
+            std::cerr << "Error reading image data!" << "\n";
+            return -1;
+        }
+
+        bitmap.build(band.data(), width, rows, threshold);
+        for(int row = 0; row < rows; ++row){
+            labelRow(bitmap, row, bandStart + row, band.data() + static_cast<size_t>(row) * width);
+            finishRow(bandStart + row, minValidSize, emitted, callback);
+        }
+    }
+
+    //everything still open touches the last row and is now finished
+    currentRuns.clear();
+    finishRow(height, minValidSize, emitted, callback);
+    return emitted;
+}
+
+/**
+ * Opens an image file and extracts its components band by band.
+ *
+ * @param fileName The PGM or PPM file to read.
+ * @return The number of components emitted, or -1 if the file could not be read.
+ */
+int StreamingExtractor::extract(const std::string & fileName, unsigned char threshold, int minValidSize, const ComponentCallback & callback){
+    std::ifstream in(fileName, std::ios::binary);
+    if(!in){
+        std::cerr << "Failed to open file for read: " << fileName << "\n";
+        return -1;
+    }
+    return extract(in, threshold, minValidSize, callback);
+}
+
+/**
+ * @return the width of the last image
+ */
+int StreamingExtractor::getWidth() const{
+    return width;
+}
+
+/**
+ * @return the height of the last image
+ */
+int StreamingExtractor::getHeight() const{
+    return height;
+}
+
+/**
+ * @return the most components that were open at the same time during the last extraction
+ */
+size_t StreamingExtractor::getPeakOpenComponents() const{
+    return peakOpenComponents;
+}
+
+/**
+ * @return the most runs held by the open components at the same time during the last extraction
+ */
+size_t StreamingExtractor::getPeakOpenRuns() const{
+    return peakOpenRuns;
+}
@@ -0,0 +1,153 @@
+#ifndef _STREAMINGEXTRACTOR_H
+#define _STREAMINGEXTRACTOR_H
+#include "ConnectedComponent.h"
+#include "ForegroundBitmap.h"
+#include <functional>
+
+/**
+ * StreamingExtractor class
+ *
+ * Extracts the connected components of a PGM/PPM image without ever holding the whole image.
+ * The raster is read a band of rows at a time and labeled as horizontal runs. Only the runs of the
+ * previous row and the components that are still growing are kept. A component that has no run on
+ * the current row can no longer grow, so it is finished and handed to a callback straight away.
+ *
+ * Peak memory is the band (bandRows * width bytes), two rows of runs, one slot per open component
+ * (at most one per run of the previous row), and, by default, every run of the open components, since
+ * each component is emitted with its runs. A component that covers most of the image keeps all of its
+ * runs until the end, so this last part can grow with the area (see getPeakOpenRuns).
+ * With setKeepRuns(false) only the size, bounding box and moment and intensity sums of each open
+ * component are kept, and components are emitted as summaries without their pixels, so peak memory
+ * grows with the image width alone whatever the shape of the components.
+ *
+ * Components are emitted (and given IDs) in the order they are finished, which is not the raster
+ * order used by PGMimageProcessor::extractComponents, but the set of components is the same.
+ *
+ * @author Nikita Martin
+ * MRTNIK003
+ * @version 1
+ */
+class StreamingExtractor{
+    public:
+        //Receives each finished component that is at least minValidSize pixels
+        typedef std::function<void(ConnectedComponent component)> ComponentCallback;
+
+    private:
+        /**
+         * A run on the current or previous row, with the slot of the component it belongs to
+         */
+        struct LabeledRun{
+            int xStart;
+            int xEnd;
+            int slot;
+        };
+
+        int bandRows; //number of rows read from the file at a time
+        int connectivity; //4 or 8
+        int width, height; //dimensions of the last image
+        size_t peakOpenComponents; //most components that were growing at the same time
+        bool keepRuns; //false to keep only the size, bounding box and sums of each open component
+        size_t openRunCount; //number of runs held by the open components
+        size_t peakOpenRuns; //most runs held by the open components at the same time
+
+        //per-image state, every open component lives in a slot
+        std::vector<ConnectedComponent::RunList> openRuns; //runs of the component in each slot
+        std::vector<int> openSizes; //number of pixels of the component in each slot
+        std::vector<ConnectedComponent::Statistics> openStatistics; //moment and intensity sums of the component in each slot
+        std::vector< std::tuple<int, int, int, int> > openBoxes; //bounding box (x_min, y_min, x_max, y_max) of the component in each slot
+        std::vector<int> lastRow; //last row on which each slot's component got a run, -2 once it is finished
+        std::vector<int> parent; //union-find over slots, a merged slot points at the slot it was merged into
+        std::vector<int> freeSlots; //slots that can be reused
+        std::vector<int> releasedSlots; //slots merged away or finished on the current row, freed once the row is done
+        std::vector<LabeledRun> previousRuns, currentRuns;
+        size_t openCount; //number of components still growing
+
+        //Starts a new open component and returns its slot
+        int newSlot();
+
+        //Returns the slot a component lives in after any merges
+        int findSlot(int slot);
+
+        //Merges the components in two slots and returns the slot of the result
+        int mergeSlots(int a, int b);
+
+        //Splits a row into runs and attaches them to the components above, summing the grey levels in rowPixels
+        void labelRow(const ForegroundBitmap & band, int bandRow, int y, const unsigned char * rowPixels);
+
+        //Emits the components that got no run on row y
+        void finishRow(int y, int minValidSize, int & emitted, const ComponentCallback & callback);
+
+        //Hands a finished component to the callback and releases its slot
+        void emit(int slot, int minValidSize, int & emitted, const ComponentCallback & callback);
+
+    public:
+        /**
+         * Default constructor - reads 64 rows at a time
+         */
+        StreamingExtractor(int bandRows = 64);
+
+        /**
+         * Sets the number of rows read from the file at a time
+         */
+        void setBandRows(int rows);
+
+        /**
+         * @return the number of rows read from the file at a time
+         */
+        int getBandRows() const;
+
+        /**
+         * Sets whether components are emitted with their runs (the default), or as summaries of their size,
+         * bounding box and sums, which keeps peak memory proportional to the width for any image
+         */
+        void setKeepRuns(bool keep);
+
+        /**
+         * @return true if components are emitted with their runs
+         */
+        bool getKeepRuns() const;
+
+        /**
+         * Sets the connectivity (4 or 8) of the following extractions
+         */
+        void setConnectivity(int connectivity);
+
+        /**
+         * @return the connectivity, 4 or 8
+         */
+        int getConnectivity() const;
+
+        /**
+         * Extracts the components of a PGM (P5) or PPM (P6) stream, emitting each one as soon as it is finished
+         * @return the number of components emitted, or -1 if the stream is not a valid image
+         */
+        int extract(std::istream & in, unsigned char threshold, int minValidSize, const ComponentCallback & callback);
+
+        /**
+         * Opens a file and extracts its components
+         * @return the number of components emitted, or -1 if the file could not be read
+         */
+        int extract(const std::string & fileName, unsigned char threshold, int minValidSize, const ComponentCallback & callback);
+
+        /**
+         * @return the width of the last image
+         */
+        int getWidth() const;
+
+        /**
+         * @return the height of the last image
+         */
+        int getHeight() const;
+
+        /**
+         * @return the most components that were open at the same time during the last extraction
+         */
+        size_t getPeakOpenComponents() const;
+
+        /**
+         * @return the most runs held by the open components at the same time during the last extraction (0 without runs)
+         */
+        size_t getPeakOpenRuns() const;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef _UNIONFIND_H
+#define _UNIONFIND_H
+#include <vector>
+#include <atomic>
+
+/**
+ * UnionFind class
+ *
+ * Array-based disjoint set forest used by the raster-scan labeling engines.
+ * Each provisional label is an index into the parent array. Sets are always
+ * linked so that the smallest label becomes the root, which means the root of
+ * a set is the label that was created first during the raster scan.
+ *
+ * The hot methods are defined inline here because they are called once per
+ * foreground pixel.
+ *
+ * findConcurrent/uniteConcurrent may be called from several threads at once (as
+ * long as no other method is running) and are used to merge labels across the
+ * seams of the parallel labeling strips.
+ */
+class UnionFind{
+    private:
+        std::vector<int> parent; //parent[i] == i when i is the root of its set
+
+    public:
+        /**
+         * Removes all labels but keeps the allocated capacity
+         */
+        void clear(){
+            parent.clear();
+        }
+
+        /**
+         * Reserves space for n labels so makeSet never reallocates
+         */
+        void reserve(size_t n){
+            parent.reserve(n);
+        }
+
+        /**
+         * @return the number of labels created so far
+         */
+        int size() const{
+            return static_cast<int>(parent.size());
+        }
+
+        /**
+         * Creates a new singleton set
+         * @return the label of the new set
+         */
+        int makeSet(){
+            int label = static_cast<int>(parent.size());
+            parent.push_back(label);
+            return label;
+        }
+
+        /**
+         * Appends every label of another forest after the labels of this one.
+         * Label i of other becomes label size() + i of this forest.
+         */
+        void append(const UnionFind & other){
+            int offset = size();
+            parent.reserve(parent.size() + other.parent.size());
+            for(int p : other.parent){
+                parent.push_back(p + offset);
+            }
+        }
+
+        /**
+         * Finds the root of a label, compressing the path along the way
+         * @return the root label of the set containing label
+         */
+        int find(int label){
+            int root = label;
+            while(parent[root] != root){
+                root = parent[root];
+            }
+            //path compression - point every label on the path straight at the root
+            while(parent[label] != root){
+                int next = parent[label];
+                parent[label] = root;
+                label = next;
+            }
+            return root;
+        }
+
+        /**
+         * Merges the sets containing a and b, the smaller root becomes the new root
+         * @return the root of the merged set
+         */
+        int unite(int a, int b){
+            int rootA = find(a);
+            int rootB = find(b);
+            if(rootA < rootB){
+                parent[rootB] = rootA;
+                return rootA;
+            }
+            parent[rootA] = rootB;
+            return rootB;
+        }
+
+        /**
+         * Thread safe find - follows the parent links without compressing them
+         * @return the root of the set containing label at the time of the call
+         */
+        int findConcurrent(int label){
+            int next = std::atomic_ref<int>(parent[label]).load(std::memory_order_acquire);
+            while(next != label){
+                label = next;
+                next = std::atomic_ref<int>(parent[label]).load(std::memory_order_acquire);
+            }
+            return label;
+        }
+
+        /**
+         * Thread safe unite - links the larger root under the smaller one with a compare-and-swap,
+         * retrying if another thread re-linked either root in the meantime.
+         */
+        void uniteConcurrent(int a, int b){
+            while(true){
+                a = findConcurrent(a);
+                b = findConcurrent(b);
+                if(a == b){
+                    return;
+                }
+                if(a > b){
+                    std::swap(a, b);
+                }
+                //b is only still a root if its parent is itself
+                int expected = b;
+                if(std::atomic_ref<int>(parent[b]).compare_exchange_strong(expected, a, std::memory_order_acq_rel)){
+                    return;
+                }
+            }
+        }
+};
+
+#endif
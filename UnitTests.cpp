@@ -1,4 +1,12 @@
 #include "PGMimageProcessor.h"
+#include "StreamingExtractor.h"
+#include "MaxTree.h"
+#include "BatchProcessor.h"
+#include "ImageGenerator.h"
+#include "GreyConverter.h"
+#include "Logger.h"
+#include <algorithm>
+#include <random>
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 
@@ -274,4 +282,1949 @@ TEST_CASE("PGMimageProcessor class TEST"){
         REQUIRE(imageProcessor.getComponentCount() == 8);
     }
 
-}
\ No newline at end of file
+}
+
+/**
+ * Unit tests for the labeling engines.
+ * Every engine must produce the same components, with the same IDs, as the Breadth First Search.
+ */
+TEST_CASE("Labeling engines TEST"){
+    /**
+     * Checks that two processors hold identical component lists (IDs, sizes, bounding boxes and pixel sets).
+     */
+    auto requireSameComponents = [](PGMimageProcessor & expected, PGMimageProcessor & actual){
+        std::span<const ConnectedComponent> expectedComponents = expected.getComponents();
+        std::span<const ConnectedComponent> actualComponents = actual.getComponents();
+        REQUIRE(expectedComponents.size() == actualComponents.size());
+
+        for(size_t i = 0; i < expectedComponents.size(); ++i){
+            REQUIRE(expectedComponents[i].getID() == actualComponents[i].getID());
+            REQUIRE(expectedComponents[i].getSize() == actualComponents[i].getSize());
+            REQUIRE(expectedComponents[i].getBoundingBox() == actualComponents[i].getBoundingBox());
+
+            std::vector< std::pair<int, int> > expectedPixels(expectedComponents[i].getPixels().begin(), expectedComponents[i].getPixels().end());
+            std::vector< std::pair<int, int> > actualPixels(actualComponents[i].getPixels().begin(), actualComponents[i].getPixels().end());
+            std::sort(expectedPixels.begin(), expectedPixels.end());
+            std::sort(actualPixels.begin(), actualPixels.end());
+            REQUIRE(expectedPixels == actualPixels);
+        }
+    };
+
+    PGMimageProcessor bfs;
+    REQUIRE(bfs.readPGM<false>("input/Birds-1.pgm"));
+    PGMimageProcessor unionFind(bfs);
+
+    SECTION("Union-find matches BFS", "[extractComponents]"){
+        std::cout << "Testing the labeling engines: union-find against BFS" << std::endl;
+        int bfsCount = bfs.extractComponents(35, 2, LabelingEngine::BFS);
+        int unionFindCount = unionFind.extractComponents(35, 2, LabelingEngine::UnionFind);
+
+        REQUIRE(bfsCount == 8);
+        REQUIRE(unionFindCount == bfsCount);
+        requireSameComponents(bfs, unionFind);
+    }
+
+    SECTION("Union-find matches BFS with every component kept", "[extractComponents]"){
+        std::cout << "Testing the labeling engines: union-find against BFS (no minimum size)" << std::endl;
+        bfs.extractComponents(128, 1, LabelingEngine::BFS);
+        unionFind.extractComponents(128, 1, LabelingEngine::UnionFind);
+        requireSameComponents(bfs, unionFind);
+    }
+
+    SECTION("Parallel union-find matches BFS", "[extractComponents]"){
+        std::cout << "Testing the labeling engines: multi-threaded union-find against BFS" << std::endl;
+        bfs.extractComponents(35, 2, LabelingEngine::BFS);
+
+        for(int threads : {2, 3, 7, 16}){
+            unionFind.setThreadCount(threads);
+            REQUIRE(unionFind.getThreadCount() == threads);
+            unionFind.extractComponents(35, 2, LabelingEngine::UnionFind);
+            requireSameComponents(bfs, unionFind);
+        }
+    }
+
+    SECTION("Parallel union-find with components crossing every seam", "[extractComponents]"){
+        std::cout << "Testing the labeling engines: multi-threaded union-find with many seams" << std::endl;
+        bfs.extractComponents(1, 1, LabelingEngine::BFS);
+        unionFind.setThreadCount(64);
+        unionFind.extractComponents(1, 1, LabelingEngine::UnionFind);
+        requireSameComponents(bfs, unionFind);
+    }
+
+    SECTION("Run-length engine matches BFS", "[extractComponents]"){
+        std::cout << "Testing the labeling engines: run-length against BFS" << std::endl;
+        bfs.extractComponents(35, 2, LabelingEngine::BFS);
+        unionFind.extractComponents(35, 2, LabelingEngine::RunLength);
+        requireSameComponents(bfs, unionFind);
+        REQUIRE(unionFind.getComponents()[0].isRunLength());
+
+        bfs.extractComponents(128, 1, LabelingEngine::BFS);
+        unionFind.extractComponents(128, 1, LabelingEngine::RunLength);
+        requireSameComponents(bfs, unionFind);
+    }
+
+    SECTION("Run-length output matches BFS output", "[writeComponents]"){
+        std::cout << "Testing the labeling engines: run-length writeComponents against BFS" << std::endl;
+        bfs.extractComponents(35, 2, LabelingEngine::BFS);
+        unionFind.extractComponents(35, 2, LabelingEngine::RunLength);
+        REQUIRE(bfs.writeComponents<int>("output/test_bfs_output"));
+        REQUIRE(unionFind.writeComponents<int>("output/test_runs_output"));
+        REQUIRE(bfs.writeComponents<int, false>("output/test_bfs_output"));
+        REQUIRE(unionFind.writeComponents<int, false>("output/test_runs_output"));
+
+        for(const char * extension : {".pgm", ".ppm"}){
+            std::ifstream bfsFile(std::string("output/test_bfs_output") + extension, std::ios::binary);
+            std::ifstream runsFile(std::string("output/test_runs_output") + extension, std::ios::binary);
+            std::string bfsBytes((std::istreambuf_iterator<char>(bfsFile)), std::istreambuf_iterator<char>());
+            std::string runsBytes((std::istreambuf_iterator<char>(runsFile)), std::istreambuf_iterator<char>());
+            REQUIRE(!bfsBytes.empty());
+            REQUIRE(bfsBytes == runsBytes);
+        }
+    }
+}
+
+/**
+ * Unit tests for run-length encoded components.
+ */
+TEST_CASE("Run-length ConnectedComponent TEST"){
+    std::vector<ConnectedComponent::Run> runs = {{2, 1, 3}, {3, 0, 4}};
+    ConnectedComponent c(5, runs);
+
+    SECTION("Size and bounding box"){
+        REQUIRE(c.getID() == 5);
+        REQUIRE(c.getSize() == 8);
+        REQUIRE(c.isRunLength());
+        REQUIRE(c.getBoundingBox() == std::make_tuple(0, 2, 4, 3));
+    }
+
+    SECTION("Pixels are expanded from the runs"){
+        ConnectedComponent::PixelList expected = {{1, 2}, {2, 2}, {3, 2}, {0, 3}, {1, 3}, {2, 3}, {3, 3}, {4, 3}};
+        REQUIRE(c.getPixels() == expected);
+
+        c.addPixel(7, 3);
+        REQUIRE(c.getSize() == 9);
+        REQUIRE(c.getRuns().size() == 3);
+        REQUIRE(c.getPixels().size() == 9);
+        REQUIRE(c.getXMax() == 7);
+    }
+
+    SECTION("Copy and move keep the runs"){
+        ConnectedComponent copy(c);
+        REQUIRE(copy.getRuns().size() == 2);
+        REQUIRE(copy.getSize() == 8);
+
+        ConnectedComponent moved(std::move(copy));
+        REQUIRE(moved.getRuns().size() == 2);
+        REQUIRE(copy.getRuns().empty());
+        REQUIRE(copy.getSize() == 0);
+    }
+}
+
+/**
+ * Unit tests for the ForegroundBitmap class.
+ */
+TEST_CASE("ForegroundBitmap TEST"){
+    //odd width so every row ends part way through a word
+    const int width = 203, height = 5;
+    std::vector<unsigned char> image(width * height);
+    for(size_t i = 0; i < image.size(); ++i){
+        image[i] = static_cast<unsigned char>((i * 37) % 256);
+    }
+
+    SECTION("Every kernel matches the threshold"){
+        std::cout << "Testing the ForegroundBitmap class: threshold kernels" << std::endl;
+        for(ThresholdKernel kernel : {ThresholdKernel::Scalar, ThresholdKernel::SSE2, ThresholdKernel::AVX2}){
+            ForegroundBitmap bitmap;
+            bitmap.build(image.data(), width, height, 128, kernel);
+            for(int y = 0; y < height; ++y){
+                for(int x = 0; x < width; ++x){
+                    REQUIRE(bitmap.test(x, y) == (image[y*width + x] >= 128));
+                }
+            }
+        }
+    }
+
+    SECTION("Run boundaries"){
+        std::cout << "Testing the ForegroundBitmap class: nextForeground and nextBackground" << std::endl;
+        std::vector<unsigned char> row(width, 0);
+        std::fill(row.begin() + 60, row.begin() + 130, 255);
+        std::fill(row.begin() + 200, row.end(), 255);
+
+        ForegroundBitmap bitmap;
+        bitmap.build(row.data(), width, 1, 128);
+        REQUIRE(bitmap.nextForeground(0, 0) == 60);
+        REQUIRE(bitmap.nextBackground(0, 60) == 130);
+        REQUIRE(bitmap.nextForeground(0, 130) == 200);
+        REQUIRE(bitmap.nextBackground(0, 200) == width);
+        REQUIRE(bitmap.nextForeground(0, width) == width);
+    }
+}
+
+/**
+ * Unit tests for the memory mapped load mode.
+ */
+TEST_CASE("Memory mapped reading TEST"){
+    PGMimageProcessor copied;
+    copied.setLoadMode(LoadMode::Copy);
+    REQUIRE(copied.readPGM<false>("input/Birds-1.pgm"));
+
+    PGMimageProcessor mapped;
+    mapped.setLoadMode(LoadMode::Map);
+    REQUIRE(mapped.getLoadMode() == LoadMode::Map);
+    REQUIRE(mapped.readPGM<false>("input/Birds-1.pgm"));
+
+    SECTION("PGM pixels are a view over the file"){
+        std::cout << "Testing memory mapped reading: PGM" << std::endl;
+        REQUIRE(!copied.isMapped());
+        REQUIRE(mapped.isMapped());
+        REQUIRE(mapped.getWidth() == copied.getWidth());
+        REQUIRE(mapped.getHeight() == copied.getHeight());
+        REQUIRE(std::equal(copied.getImageData(), copied.getImageData() + copied.getWidth() * copied.getHeight(), mapped.getImageData()));
+
+        REQUIRE(mapped.extractComponents(35, 2) == 8);
+        REQUIRE(mapped.getLargestSize() == 7671);
+        REQUIRE(mapped.getSmallestSize() == 4007);
+    }
+
+    SECTION("Copies share the mapping"){
+        std::cout << "Testing memory mapped reading: copying a mapped processor" << std::endl;
+        PGMimageProcessor copy(mapped);
+        REQUIRE(copy.isMapped());
+        REQUIRE(copy.getImageData() == mapped.getImageData());
+
+        PGMimageProcessor moved(std::move(copy));
+        REQUIRE(moved.isMapped());
+        REQUIRE(moved.extractComponents(35, 2) == 8);
+    }
+
+    SECTION("PPM is converted from the mapping"){
+        std::cout << "Testing memory mapped reading: PPM" << std::endl;
+        PGMimageProcessor copiedColour;
+        copiedColour.setLoadMode(LoadMode::Copy);
+        REQUIRE(copiedColour.readPGM<true>("input/Chess_Colours.ppm"));
+
+        PGMimageProcessor mappedColour;
+        mappedColour.setLoadMode(LoadMode::Map);
+        REQUIRE(mappedColour.readPGM<true>("input/Chess_Colours.ppm"));
+        REQUIRE(!mappedColour.isMapped());
+        REQUIRE(std::equal(copiedColour.getImageData(), copiedColour.getImageData() + copiedColour.getWidth() * copiedColour.getHeight(), mappedColour.getImageData()));
+    }
+
+    SECTION("Small files are copied by default"){
+        std::cout << "Testing memory mapped reading: automatic load mode" << std::endl;
+        PGMimageProcessor automatic;
+        REQUIRE(automatic.getLoadMode() == LoadMode::Auto);
+        REQUIRE(automatic.readPGM<false>("input/Birds-1.pgm"));
+        REQUIRE(!automatic.isMapped());
+
+        //reading a file into a mapped processor replaces the mapping with an owned copy
+        mapped.setLoadMode(LoadMode::Copy);
+        REQUIRE(mapped.readPGM<false>("input/Birds-1.pgm"));
+        REQUIRE(!mapped.isMapped());
+    }
+
+    SECTION("A file that fails its checks keeps the previous image"){
+        std::cout << "Testing memory mapped reading: invalid files" << std::endl;
+        REQUIRE(mapped.extractComponents(35, 2) == 8);
+        const unsigned char * pixels = mapped.getImageData();
+        {
+            //the header claims far more pixels than the file holds
+            std::ofstream truncated("output/test_truncated.pgm", std::ios::binary);
+            truncated << "P5\n4000 3000\n255\n" << std::string(100, '\xff');
+            std::ofstream badMaxVal("output/test_bad_maxval.pgm", std::ios::binary);
+            badMaxVal << "P5\n20 10\n65535\n" << std::string(400, '\xff');
+        }
+        for(const char * fileName : {"output/test_truncated.pgm", "output/test_bad_maxval.pgm"}){
+            REQUIRE(!mapped.readPGM<false>(fileName));
+            REQUIRE(mapped.isMapped());
+            REQUIRE(mapped.getImageData() == pixels);
+            REQUIRE(mapped.getWidth() == copied.getWidth());
+            REQUIRE(mapped.getHeight() == copied.getHeight());
+            REQUIRE(mapped.getComponentCount() == 8);
+            REQUIRE(mapped.getLabelAt(copied.getWidth() - 1, copied.getHeight() - 1) >= -1);
+        }
+    }
+}
+
+/**
+ * Unit tests for the StreamingExtractor class.
+ * The streamed components come out in a different order, so they are compared as sets of pixel sets.
+ */
+TEST_CASE("StreamingExtractor TEST"){
+    /**
+     * @return the pixel list of each component (sorted), in sorted order
+     */
+    auto pixelSets = [](const std::vector<ConnectedComponent> & components){
+        std::vector< std::vector< std::pair<int, int> > > sets;
+        for(const ConnectedComponent & component : components){
+            std::vector< std::pair<int, int> > pixels(component.getPixels().begin(), component.getPixels().end());
+            std::sort(pixels.begin(), pixels.end());
+            sets.push_back(pixels);
+        }
+        std::sort(sets.begin(), sets.end());
+        return sets;
+    };
+
+    SECTION("Streamed PGM components match extractComponents"){
+        std::cout << "Testing the StreamingExtractor class: PGM" << std::endl;
+        PGMimageProcessor processor;
+        REQUIRE(processor.readPGM<false>("input/Birds-1.pgm"));
+
+        for(int threshold : {35, 128}){
+            processor.extractComponents(threshold, 2);
+            std::vector<ConnectedComponent> expected;
+            for(const ConnectedComponent & component : processor.getComponents()){
+                expected.push_back(component);
+            }
+
+            for(int bandRows : {1, 7, 64, 2000}){
+                StreamingExtractor extractor(bandRows);
+                std::vector<ConnectedComponent> streamed;
+                int emitted = extractor.extract("input/Birds-1.pgm", threshold, 2, [&](ConnectedComponent component){
+                    REQUIRE(component.getID() == static_cast<int>(streamed.size()));
+                    streamed.push_back(std::move(component));
+                });
+
+                REQUIRE(emitted == processor.getComponentCount());
+                REQUIRE(extractor.getWidth() == processor.getWidth());
+                REQUIRE(extractor.getHeight() == processor.getHeight());
+                REQUIRE(pixelSets(streamed) == pixelSets(expected));
+                REQUIRE(extractor.getPeakOpenComponents() > 0);
+            }
+        }
+    }
+
+    SECTION("Streamed PPM components match extractComponents"){
+        std::cout << "Testing the StreamingExtractor class: PPM" << std::endl;
+        PGMimageProcessor processor;
+        REQUIRE(processor.readPGM<true>("input/Chess_Colours.ppm"));
+        processor.extractComponents(171, 1);
+        std::vector<ConnectedComponent> expected;
+        for(const ConnectedComponent & component : processor.getComponents()){
+            expected.push_back(component);
+        }
+
+        StreamingExtractor extractor(16);
+        std::vector<ConnectedComponent> streamed;
+        extractor.extract("input/Chess_Colours.ppm", 171, 1, [&](ConnectedComponent component){
+            streamed.push_back(std::move(component));
+        });
+        REQUIRE(pixelSets(streamed) == pixelSets(expected));
+    }
+
+    SECTION("Summaries keep memory proportional to the width"){
+        std::cout << "Testing the StreamingExtractor class: summaries of a component that covers the image" << std::endl;
+        const int width = 600, height = 600;
+        REQUIRE(ImageGenerator::writePGM("output/test_spiral.pgm", ImageGenerator::generate(SyntheticPattern::Spiral, width, height), width, height));
+
+        StreamingExtractor withRuns(32);
+        std::vector<ConnectedComponent> expected;
+        withRuns.extract("output/test_spiral.pgm", 128, 1, [&](ConnectedComponent component){
+            expected.push_back(std::move(component));
+        });
+        REQUIRE(expected.size() == 1);
+        //with its runs, the open spiral holds a number of runs that grows with the area
+        REQUIRE(withRuns.getPeakOpenRuns() == expected[0].getRuns().size());
+        REQUIRE(withRuns.getPeakOpenRuns() > static_cast<size_t>(width * 10));
+
+        StreamingExtractor summaries(32);
+        summaries.setKeepRuns(false);
+        REQUIRE_FALSE(summaries.getKeepRuns());
+        std::vector<ConnectedComponent> streamed;
+        int emitted = summaries.extract("output/test_spiral.pgm", 128, 1, [&](ConnectedComponent component){
+            streamed.push_back(std::move(component));
+        });
+        REQUIRE(emitted == 1);
+        REQUIRE(summaries.getPeakOpenRuns() == 0);
+        REQUIRE(summaries.getPeakOpenComponents() <= static_cast<size_t>(width));
+
+        REQUIRE(streamed[0].getID() == expected[0].getID());
+        REQUIRE(streamed[0].getSize() == expected[0].getSize());
+        REQUIRE(streamed[0].getBoundingBox() == expected[0].getBoundingBox());
+        REQUIRE(streamed[0].getCentroid() == expected[0].getCentroid());
+        REQUIRE(streamed[0].getSecondMoments() == expected[0].getSecondMoments());
+        REQUIRE(streamed[0].getMeanIntensity() == expected[0].getMeanIntensity());
+        REQUIRE(streamed[0].getRuns().empty());
+        REQUIRE(streamed[0].getPixels().empty());
+    }
+
+    SECTION("Summaries match the components with runs"){
+        std::cout << "Testing the StreamingExtractor class: summaries of many components" << std::endl;
+        StreamingExtractor withRuns(7), summaries(7);
+        summaries.setKeepRuns(false);
+        std::vector<ConnectedComponent> expected, streamed;
+        withRuns.extract("input/Birds-1.pgm", 35, 2, [&](ConnectedComponent component){
+            expected.push_back(std::move(component));
+        });
+        summaries.extract("input/Birds-1.pgm", 35, 2, [&](ConnectedComponent component){
+            streamed.push_back(std::move(component));
+        });
+        REQUIRE(streamed.size() == expected.size());
+        for(size_t i = 0; i < streamed.size(); ++i){
+            REQUIRE(streamed[i].getSize() == expected[i].getSize());
+            REQUIRE(streamed[i].getBoundingBox() == expected[i].getBoundingBox());
+            REQUIRE(streamed[i].getCentroid() == expected[i].getCentroid());
+            REQUIRE(streamed[i].getMinIntensity() == expected[i].getMinIntensity());
+            REQUIRE(streamed[i].getMaxIntensity() == expected[i].getMaxIntensity());
+        }
+    }
+
+    SECTION("Invalid input"){
+        std::cout << "Testing the StreamingExtractor class: invalid input" << std::endl;
+        StreamingExtractor extractor;
+        std::istringstream notAnImage("P2\n2 2\n255\n0 0 0 0\n");
+        REQUIRE(extractor.extract(notAnImage, 128, 1, [](ConnectedComponent){}) == -1);
+        REQUIRE(extractor.extract("input/missing.pgm", 128, 1, [](ConnectedComponent){}) == -1);
+    }
+}
+
+/**
+ * Unit tests for 8-connectivity.
+ * Uses a random noise image, where diagonal connections change almost every component.
+ */
+TEST_CASE("8-connectivity TEST"){
+    const int width = 257, height = 131;
+    {
+        std::ofstream noise("output/test_noise.pgm", std::ios::binary);
+        noise << "P5\n" << width << " " << height << "\n255\n";
+        std::mt19937 random(7);
+        for(int i = 0; i < width * height; ++i){
+            noise.put(static_cast<char>(random() % 256));
+        }
+    }
+
+    PGMimageProcessor bfs;
+    REQUIRE(bfs.readPGM<false>("output/test_noise.pgm"));
+    PGMimageProcessor other(bfs);
+
+    /**
+     * @return the sorted pixel list of every component of a processor
+     */
+    auto pixelSets = [](PGMimageProcessor & processor){
+        std::vector< std::vector< std::pair<int, int> > > sets;
+        for(const ConnectedComponent & component : processor.getComponents()){
+            std::vector< std::pair<int, int> > pixels(component.getPixels().begin(), component.getPixels().end());
+            std::sort(pixels.begin(), pixels.end());
+            sets.push_back(pixels);
+        }
+        return sets;
+    };
+
+    SECTION("Diagonal pixels are connected"){
+        std::cout << "Testing 8-connectivity: fewer, larger components than 4-connectivity" << std::endl;
+        int fourConnected = bfs.extractComponents(128, 1, LabelingEngine::BFS, 4);
+        int largestFour = bfs.getLargestSize();
+        int eightConnected = bfs.extractComponents(128, 1, LabelingEngine::BFS, 8);
+        REQUIRE(eightConnected < fourConnected);
+        REQUIRE(bfs.getLargestSize() > largestFour);
+    }
+
+    SECTION("Every engine matches BFS"){
+        std::cout << "Testing 8-connectivity: union-find, run-length and parallel union-find against BFS" << std::endl;
+        bfs.extractComponents(128, 1, LabelingEngine::BFS, 8);
+        std::vector< std::vector< std::pair<int, int> > > expected = pixelSets(bfs);
+
+        other.extractComponents(128, 1, LabelingEngine::UnionFind, 8);
+        REQUIRE(pixelSets(other) == expected);
+
+        other.extractComponents(128, 1, LabelingEngine::RunLength, 8);
+        REQUIRE(pixelSets(other) == expected);
+
+        other.setThreadCount(9);
+        other.extractComponents(128, 1, LabelingEngine::UnionFind, 8);
+        REQUIRE(pixelSets(other) == expected);
+    }
+
+    SECTION("Streaming matches BFS"){
+        std::cout << "Testing 8-connectivity: StreamingExtractor against BFS" << std::endl;
+        bfs.extractComponents(128, 1, LabelingEngine::BFS, 8);
+
+        StreamingExtractor extractor(10);
+        extractor.setConnectivity(8);
+        REQUIRE(extractor.getConnectivity() == 8);
+        std::vector<int> streamedSizes;
+        extractor.extract("output/test_noise.pgm", 128, 1, [&](ConnectedComponent component){
+            streamedSizes.push_back(component.getSize());
+        });
+
+        std::vector<int> expectedSizes;
+        for(const ConnectedComponent & component : bfs.getComponents()){
+            expectedSizes.push_back(component.getSize());
+        }
+        std::sort(streamedSizes.begin(), streamedSizes.end());
+        std::sort(expectedSizes.begin(), expectedSizes.end());
+        REQUIRE(streamedSizes == expectedSizes);
+    }
+
+    SECTION("Invalid connectivity"){
+        std::cout << "Testing 8-connectivity: unsupported connectivity" << std::endl;
+        REQUIRE(bfs.extractComponents(128, 1, LabelingEngine::BFS, 6) == 0);
+        REQUIRE(bfs.getComponentCount() == 0);
+    }
+}
+
+/**
+ * Unit tests for the histogram counted by readPGM and the Otsu threshold picked from it.
+ */
+TEST_CASE("Histogram and Otsu threshold TEST"){
+    /**
+     * @return the histogram counted straight from the pixels of a processor
+     */
+    auto countPixels = [](const PGMimageProcessor & processor){
+        std::array<size_t, 256> counts{};
+        const unsigned char * pixels = processor.getImageData();
+        for(size_t i = 0; i < static_cast<size_t>(processor.getWidth()) * processor.getHeight(); ++i){
+            ++counts[pixels[i]];
+        }
+        return counts;
+    };
+
+    SECTION("Histogram matches the pixels"){
+        std::cout << "Testing histogram: PGM and PPM" << std::endl;
+        PGMimageProcessor grey;
+        grey.setLoadMode(LoadMode::Copy);
+        REQUIRE(grey.readPGM<false>("input/Birds-1.pgm"));
+        REQUIRE(grey.getHistogram() == countPixels(grey));
+
+        size_t total = 0;
+        for(size_t count : grey.getHistogram()){
+            total += count;
+        }
+        REQUIRE(total == static_cast<size_t>(grey.getWidth()) * grey.getHeight());
+
+        PGMimageProcessor colour;
+        REQUIRE(colour.readPGM<true>("input/Chess_Colours.ppm"));
+        REQUIRE(colour.getHistogram() == countPixels(colour));
+    }
+
+    SECTION("Mapped histogram matches the copied one"){
+        std::cout << "Testing histogram: memory mapped PGM" << std::endl;
+        PGMimageProcessor copied;
+        copied.setLoadMode(LoadMode::Copy);
+        REQUIRE(copied.readPGM<false>("input/Birds-1.pgm"));
+
+        PGMimageProcessor mapped;
+        mapped.setLoadMode(LoadMode::Map);
+        REQUIRE(mapped.readPGM<false>("input/Birds-1.pgm"));
+        REQUIRE(mapped.getHistogram() == copied.getHistogram());
+        REQUIRE(mapped.getOtsuThreshold() == copied.getOtsuThreshold());
+    }
+
+    SECTION("Otsu threshold separates two blobs from the background"){
+        std::cout << "Testing Otsu threshold: bimodal image" << std::endl;
+        const int width = 120, height = 80;
+        {
+            std::ofstream out("output/test_bimodal.pgm", std::ios::binary);
+            out << "P5\n" << width << " " << height << "\n255\n";
+            std::mt19937 random(3);
+            for(int y = 0; y < height; ++y){
+                for(int x = 0; x < width; ++x){
+                    bool blob = (x >= 10 && x < 40 && y >= 10 && y < 40) || (x >= 70 && x < 110 && y >= 30 && y < 70);
+                    out.put(static_cast<char>((blob ? 170 : 60) + random() % 21));
+                }
+            }
+        }
+
+        PGMimageProcessor processor;
+        REQUIRE(processor.readPGM<false>("output/test_bimodal.pgm"));
+        int threshold = processor.getOtsuThreshold();
+        REQUIRE(threshold > 80);
+        REQUIRE(threshold <= 170);
+        REQUIRE(processor.extractComponents(threshold, 1) == 2);
+        REQUIRE(processor.getLargestSize() == 40 * 40);
+        REQUIRE(processor.getSmallestSize() == 30 * 30);
+    }
+
+    SECTION("Single grey level"){
+        std::cout << "Testing Otsu threshold: flat image" << std::endl;
+        {
+            std::ofstream out("output/test_flat.pgm", std::ios::binary);
+            out << "P5\n16 16\n255\n" << std::string(16 * 16, static_cast<char>(90));
+        }
+        PGMimageProcessor processor;
+        REQUIRE(processor.readPGM<false>("output/test_flat.pgm"));
+        REQUIRE(processor.getHistogram()[90] == 16 * 16);
+        REQUIRE(processor.getOtsuThreshold() == 128);
+    }
+}
+
+/**
+ * Unit tests for MaxTree.
+ * The components read from the tree must have the same sizes as the ones extractComponents finds at each threshold.
+ */
+TEST_CASE("MaxTree TEST"){
+    /**
+     * @return the sorted sizes of the components extracted at a threshold
+     */
+    auto extractedSizes = [](PGMimageProcessor & processor, int threshold, int minValidSize, int connectivity){
+        processor.extractComponents(threshold, minValidSize, LabelingEngine::RunLength, connectivity);
+        std::vector<int> sizes;
+        for(const ConnectedComponent & component : processor.getComponents()){
+            sizes.push_back(component.getSize());
+        }
+        std::sort(sizes.begin(), sizes.end());
+        return sizes;
+    };
+
+    SECTION("Every threshold matches extractComponents"){
+        std::cout << "Testing MaxTree: component sizes at every threshold" << std::endl;
+        const int width = 97, height = 61;
+        {
+            std::ofstream out("output/test_levels.pgm", std::ios::binary);
+            out << "P5\n" << width << " " << height << "\n255\n";
+            std::mt19937 random(11);
+            for(int i = 0; i < width * height; ++i){
+                out.put(static_cast<char>(random() % 256));
+            }
+        }
+        PGMimageProcessor processor;
+        REQUIRE(processor.readPGM<false>("output/test_levels.pgm"));
+
+        for(int connectivity : {4, 8}){
+            MaxTree tree;
+            REQUIRE(tree.build(processor.getImageData(), width, height, connectivity));
+            for(int threshold = 0; threshold < 256; threshold += 5){
+                std::vector<int> sizes = tree.componentSizes(threshold, 1);
+                std::sort(sizes.begin(), sizes.end());
+                REQUIRE(sizes == extractedSizes(processor, threshold, 1, connectivity));
+                REQUIRE(tree.countComponents(threshold, 3) == processor.extractComponents(threshold, 3, LabelingEngine::RunLength, connectivity));
+            }
+        }
+    }
+
+    SECTION("Sweep over a real image"){
+        std::cout << "Testing MaxTree: Birds-1 sweep" << std::endl;
+        PGMimageProcessor processor;
+        REQUIRE(processor.readPGM<false>("input/Birds-1.pgm"));
+        MaxTree tree;
+        REQUIRE(tree.build(processor.getImageData(), processor.getWidth(), processor.getHeight()));
+        REQUIRE(tree.getWidth() == processor.getWidth());
+        REQUIRE(tree.getNodeCount() < static_cast<size_t>(processor.getWidth()) * processor.getHeight());
+
+        REQUIRE(tree.countComponents(35, 2) == 8);
+        std::vector<int> sizes = tree.componentSizes(35, 2);
+        REQUIRE(*std::max_element(sizes.begin(), sizes.end()) == 7671);
+        REQUIRE(*std::min_element(sizes.begin(), sizes.end()) == 4007);
+
+        //every pixel is >= 0, so threshold 0 is a single component covering the image
+        REQUIRE(tree.componentSizes(0, 1) == std::vector<int>{processor.getWidth() * processor.getHeight()});
+    }
+
+    SECTION("Invalid connectivity and size"){
+        std::cout << "Testing MaxTree: unsupported connectivity and image size" << std::endl;
+        unsigned char pixels[4] = {0, 255, 255, 0};
+        MaxTree tree;
+        REQUIRE(!tree.build(pixels, 2, 2, 6));
+        REQUIRE(tree.build(pixels, 2, 2, 4));
+        REQUIRE(tree.countComponents(255, 1) == 2);
+        REQUIRE(tree.build(pixels, 2, 2, 8));
+        REQUIRE(tree.countComponents(255, 1) == 1);
+
+        //more pixels than an int can index is rejected before any pixel is read, and the last tree is kept
+        REQUIRE(!tree.build(pixels, 65536, 32768, 4));
+        REQUIRE(tree.getWidth() == 2);
+        REQUIRE(tree.countComponents(255, 1) == 1);
+    }
+}
+
+/**
+ * Unit tests for the label image.
+ */
+TEST_CASE("Label image TEST"){
+    PGMimageProcessor processor;
+    REQUIRE(processor.readPGM<false>("input/Birds-1.pgm"));
+    processor.extractComponents(35, 2);
+
+    /**
+     * Checks that every pixel of every component is labeled with its ID, and that no other pixel is labeled.
+     */
+    auto requireLabelsMatch = [](const PGMimageProcessor & processor){
+        size_t componentPixels = 0, mislabeledPixels = 0;
+        for(const ConnectedComponent & component : processor.getComponents()){
+            for(const std::pair<int, int> & pixel : component.getPixels()){
+                mislabeledPixels += (processor.getLabelAt(pixel.first, pixel.second) != component.getID());
+            }
+            componentPixels += component.getSize();
+        }
+        REQUIRE(mislabeledPixels == 0);
+        size_t labeledPixels = 0;
+        for(int y = 0; y < processor.getHeight(); ++y){
+            for(int x = 0; x < processor.getWidth(); ++x){
+                labeledPixels += (processor.getLabelAt(x, y) != -1);
+            }
+        }
+        REQUIRE(labeledPixels == componentPixels);
+    };
+
+    SECTION("Every pixel maps to its component"){
+        std::cout << "Testing label image: pixel lookup" << std::endl;
+        REQUIRE(!processor.getLabelImage().isWide());
+        requireLabelsMatch(processor);
+        REQUIRE(processor.getLabelAt(-1, 0) == -1);
+        REQUIRE(processor.getLabelAt(processor.getWidth(), 0) == -1);
+
+        PGMimageProcessor runs(processor);
+        runs.extractComponents(35, 2, LabelingEngine::RunLength);
+        requireLabelsMatch(runs);
+    }
+
+    SECTION("Filtered components are removed from the labels"){
+        std::cout << "Testing label image: filtering" << std::endl;
+        processor.getLabelImage();
+        std::pair<int, int> smallestPixel = processor.getComponents()[0].getPixels()[0];
+        int smallestID = processor.getComponents()[0].getID();
+        for(const ConnectedComponent & component : processor.getComponents()){
+            if(component.getSize() == processor.getSmallestSize()){
+                smallestPixel = component.getPixels()[0];
+                smallestID = component.getID();
+            }
+        }
+        REQUIRE(processor.getLabelAt(smallestPixel.first, smallestPixel.second) == smallestID);
+        processor.filterComponentsBySize(processor.getSmallestSize() + 1, processor.getLargestSize());
+        REQUIRE(processor.getLabelAt(smallestPixel.first, smallestPixel.second) == -1);
+        requireLabelsMatch(processor);
+    }
+
+    SECTION("16-bit PGM output"){
+        std::cout << "Testing label image: writing a 16-bit PGM" << std::endl;
+        REQUIRE(processor.writeLabelImage("output/test_labels"));
+        std::ifstream in("output/test_labels.pgm", std::ios::binary);
+        std::string magicNumber;
+        int width, height, maxVal;
+        REQUIRE(PGMimageProcessor::readHeader(in, magicNumber, width, height, maxVal));
+        REQUIRE(magicNumber == "P5");
+        REQUIRE(width == processor.getWidth());
+        REQUIRE(maxVal == 65535);
+
+        std::vector<unsigned char> samples(static_cast<size_t>(width) * height * 2);
+        in.read(reinterpret_cast<char *>(samples.data()), samples.size());
+        REQUIRE(in);
+        const ConnectedComponent & last = processor.getComponents().back();
+        std::pair<int, int> pixel = last.getPixels()[0];
+        size_t index = (static_cast<size_t>(pixel.second) * width + pixel.first) * 2;
+        REQUIRE(samples[index] * 256 + samples[index + 1] == last.getID() + 1);
+    }
+
+    SECTION("32-bit labels"){
+        std::cout << "Testing label image: more components than fit in 16 bits" << std::endl;
+        LabelImage labels;
+        labels.reset(4, 2, 70000);
+        REQUIRE(labels.isWide());
+        REQUIRE(labels.narrowData() == nullptr);
+        labels.fillRun(1, 1, 3, 69999);
+        labels.set(0, 0, 5);
+        REQUIRE(labels.at(0, 0) == 5);
+        REQUIRE(labels.at(0, 1) == -1);
+        REQUIRE(labels.at(2, 1) == 69999);
+        REQUIRE(!labels.writePGM("output/test_wide_labels.pgm"));
+
+        labels.reset(4, 2, 65534);
+        REQUIRE(!labels.isWide());
+        REQUIRE(labels.at(2, 1) == -1);
+    }
+
+    SECTION("Reading a new image drops the components of the old one"){
+        std::cout << "Testing label image: reading a larger image" << std::endl;
+        std::vector<unsigned char> small = ImageGenerator::generate(SyntheticPattern::Blobs, 60, 40, 13);
+        std::vector<unsigned char> large = ImageGenerator::generate(SyntheticPattern::Blobs, 400, 300, 14);
+        REQUIRE(ImageGenerator::writePGM("output/test_small.pgm", small, 60, 40));
+        REQUIRE(ImageGenerator::writePGM("output/test_large.pgm", large, 400, 300));
+
+        for(LoadMode mode : {LoadMode::Copy, LoadMode::Map}){
+            PGMimageProcessor reader;
+            reader.setLoadMode(mode);
+            REQUIRE(reader.readPGM<false>("output/test_small.pgm"));
+            REQUIRE(reader.extractComponents(128, 1) > 0);
+            REQUIRE(reader.getLabelAt(0, 0) >= -1); //builds the label image of the small image
+            REQUIRE(reader.getLargestSize() > 0); //and its size index
+
+            REQUIRE(reader.readPGM<false>("output/test_large.pgm"));
+            REQUIRE(reader.getComponentCount() == 0);
+            REQUIRE(reader.getLargestSize() == 0);
+            REQUIRE(reader.getComponentsBySize(1, 400 * 300).size() == 0);
+            REQUIRE(reader.getLabelAt(399, 299) == -1);
+            requireLabelsMatch(reader);
+
+            //labeling the new image works as before
+            reader.extractComponents(128, 1);
+            requireLabelsMatch(reader);
+        }
+    }
+}
+
+/**
+ * Unit tests for BatchProcessor.
+ */
+TEST_CASE("BatchProcessor TEST"){
+    std::vector<std::string> fileNames;
+    REQUIRE(BatchProcessor::listImages("input", fileNames));
+    REQUIRE(std::is_sorted(fileNames.begin(), fileNames.end()));
+    REQUIRE(std::find(fileNames.begin(), fileNames.end(), "input/Birds-1.pgm") != fileNames.end());
+
+    BatchOptions options;
+    options.threshold = 35;
+    options.minSize = 2;
+
+    SECTION("Worker pool matches one file at a time"){
+        std::cout << "Testing BatchProcessor: parallel batch against single files" << std::endl;
+        fileNames.push_back("input/missing.pgm");
+        BatchProcessor batch(options, 3);
+        REQUIRE(batch.getWorkerCount() == 3);
+
+        int callbacks = 0;
+        std::vector<BatchResult> results = batch.run(fileNames, [&](const BatchResult &){ callbacks++; });
+        REQUIRE(results.size() == fileNames.size());
+        REQUIRE(callbacks == static_cast<int>(fileNames.size()));
+
+        PGMimageProcessor processor;
+        for(size_t i = 0; i < fileNames.size(); ++i){
+            BatchResult expected = batch.processFile(processor, fileNames[i]);
+            REQUIRE(results[i].fileName == fileNames[i]);
+            REQUIRE(results[i].success == expected.success);
+            REQUIRE(results[i].components == expected.components);
+            REQUIRE(results[i].smallest == expected.smallest);
+            REQUIRE(results[i].largest == expected.largest);
+        }
+        REQUIRE(!results.back().success);
+
+        BatchResult birds = results[std::find(fileNames.begin(), fileNames.end(), "input/Birds-1.pgm") - fileNames.begin()];
+        REQUIRE(birds.components == 8);
+        REQUIRE(birds.largest == 7671);
+        REQUIRE(birds.smallest == 4007);
+    }
+
+    SECTION("Outputs are named after each input"){
+        std::cout << "Testing BatchProcessor: output names" << std::endl;
+        REQUIRE(BatchProcessor::outputName("output/comp", "input/Birds-1.pgm") == "output/comp_Birds-1");
+        options.labelImageName = "output/batch_labels";
+        options.componentFileName = "output/batch_components";
+        options.autoThreshold = true;
+        BatchProcessor batch(options, 2);
+        std::vector<BatchResult> results = batch.run({"input/Birds-1.pgm"}, [](const BatchResult &){});
+        REQUIRE(results[0].success);
+        REQUIRE(results[0].threshold == 107);
+        REQUIRE(results[0].error.empty());
+        REQUIRE(std::ifstream("output/batch_labels_Birds-1.pgm").good());
+        ComponentFile components;
+        REQUIRE(components.open("output/batch_components_Birds-1.ccx"));
+        REQUIRE(components.getComponentCount() == static_cast<size_t>(results[0].components));
+    }
+
+    SECTION("Outputs that cannot be written fail the file"){
+        std::cout << "Testing BatchProcessor: write errors" << std::endl;
+        options.outputFile = "output/missing_directory/comp";
+        BatchProcessor batch(options, 2);
+        std::vector<BatchResult> results = batch.run({"input/Birds-1.pgm", "input/missing.pgm"}, [](const BatchResult &){});
+        REQUIRE(!results[0].success);
+        REQUIRE(results[0].error == "Failed to write output/missing_directory/comp_Birds-1");
+        REQUIRE(results[0].components == 8);
+        REQUIRE(!results[1].success);
+        REQUIRE(results[1].error == "Failed to load file.");
+
+        PGMimageProcessor processor;
+        BatchResult single = batch.processFile(processor, "input/Birds-1.pgm");
+        REQUIRE(!single.success);
+        REQUIRE(single.error == results[0].error);
+    }
+
+    SECTION("Pipeline at every queue depth"){
+        std::cout << "Testing BatchProcessor: read/label/write pipeline" << std::endl;
+        std::vector<std::string> manyFiles;
+        for(int repeat = 0; repeat < 4; ++repeat){
+            manyFiles.insert(manyFiles.end(), fileNames.begin(), fileNames.end());
+        }
+        manyFiles.insert(manyFiles.begin() + 3, "input/missing.pgm");
+
+        PGMimageProcessor processor;
+        std::vector<BatchResult> expected;
+        for(const std::string & fileName : manyFiles){
+            expected.push_back(BatchProcessor(options).processFile(processor, fileName));
+        }
+
+        for(int workers : {1, 3}){
+            for(int depth : {1, 4}){
+                BatchProcessor batch(options, workers, depth);
+                REQUIRE(batch.getQueueDepth() == depth);
+                REQUIRE(batch.getProcessorCount() == workers + depth);
+                std::vector<size_t> reported;
+                std::vector<BatchResult> results = batch.run(manyFiles, [&](const BatchResult & result){
+                    reported.push_back(result.components);
+                });
+                REQUIRE(reported.size() == manyFiles.size());
+                for(size_t i = 0; i < manyFiles.size(); ++i){
+                    REQUIRE(results[i].fileName == manyFiles[i]);
+                    REQUIRE(results[i].success == expected[i].success);
+                    REQUIRE(results[i].components == expected[i].components);
+                    REQUIRE(results[i].largest == expected[i].largest);
+                }
+            }
+        }
+    }
+
+    SECTION("Bounded queue"){
+        std::cout << "Testing BatchProcessor: bounded queue" << std::endl;
+        BoundedQueue<int> queue(2);
+        REQUIRE(queue.push(1));
+        REQUIRE(queue.push(2));
+
+        //a third push waits until an item is popped
+        std::thread producer([&](){ queue.push(3); });
+        int item = 0;
+        REQUIRE(queue.pop(item));
+        REQUIRE(item == 1);
+        producer.join();
+        REQUIRE(queue.size() == 2);
+
+        queue.close();
+        REQUIRE(!queue.push(4));
+        REQUIRE(queue.pop(item));
+        REQUIRE(item == 2);
+        REQUIRE(queue.pop(item));
+        REQUIRE(item == 3);
+        REQUIRE(!queue.pop(item));
+    }
+
+    SECTION("Missing directory"){
+        std::cout << "Testing BatchProcessor: unreadable directory" << std::endl;
+        std::vector<std::string> none;
+        REQUIRE(!BatchProcessor::listImages("input/missing", none));
+        REQUIRE(none.empty());
+    }
+}
+
+/**
+ * Unit tests for the synthetic images used by the benchmarks.
+ */
+TEST_CASE("ImageGenerator TEST"){
+    const int width = 203, height = 150;
+
+    /**
+     * Writes a generated image and extracts its components at threshold 128.
+     */
+    auto extractGenerated = [](SyntheticPattern pattern, int width, int height, PGMimageProcessor & processor){
+        REQUIRE(ImageGenerator::writePGM("output/test_generated.pgm", ImageGenerator::generate(pattern, width, height), width, height));
+        REQUIRE(processor.readPGM<false>("output/test_generated.pgm"));
+        return processor.extractComponents(128, 1, LabelingEngine::RunLength);
+    };
+
+    SECTION("Spiral is a single giant component"){
+        std::cout << "Testing ImageGenerator: spiral" << std::endl;
+        PGMimageProcessor processor;
+        REQUIRE(extractGenerated(SyntheticPattern::Spiral, width, height, processor) == 1);
+        REQUIRE(processor.getLargestSize() > width * height / 3);
+    }
+
+    SECTION("Checkerboard is one component per foreground pixel"){
+        std::cout << "Testing ImageGenerator: checkerboard" << std::endl;
+        PGMimageProcessor processor;
+        REQUIRE(extractGenerated(SyntheticPattern::Checkerboard, width, height, processor) == (width * height) / 2);
+        REQUIRE(processor.getLargestSize() == 1);
+    }
+
+    SECTION("Random patterns are repeatable"){
+        std::cout << "Testing ImageGenerator: noise and blobs" << std::endl;
+        REQUIRE(ImageGenerator::generate(SyntheticPattern::Noise, width, height, 5) == ImageGenerator::generate(SyntheticPattern::Noise, width, height, 5));
+        REQUIRE(ImageGenerator::generate(SyntheticPattern::Noise, width, height, 5) != ImageGenerator::generate(SyntheticPattern::Noise, width, height, 6));
+
+        PGMimageProcessor processor;
+        int blobs = extractGenerated(SyntheticPattern::Blobs, width, height, processor);
+        REQUIRE(blobs >= 1);
+        REQUIRE(blobs <= width * height / 20000);
+    }
+
+    SECTION("Pattern names"){
+        std::cout << "Testing ImageGenerator: pattern names" << std::endl;
+        SyntheticPattern pattern;
+        REQUIRE(ImageGenerator::parsePattern("checkerboard", pattern));
+        REQUIRE(pattern == SyntheticPattern::Checkerboard);
+        REQUIRE(ImageGenerator::patternName(SyntheticPattern::Spiral) == "spiral");
+        REQUIRE(!ImageGenerator::parsePattern("stripes", pattern));
+    }
+}
+
+TEST_CASE("ProcessingStats TEST"){
+    const int width = 64, height = 32;
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    REQUIRE(ImageGenerator::writePGM("output/test_stats.pgm", ImageGenerator::generate(SyntheticPattern::Checkerboard, width, height), width, height));
+
+    SECTION("Each phase is counted"){
+        std::cout << "Testing ProcessingStats: phase counters" << std::endl;
+        PGMimageProcessor processor;
+        processor.setLoadMode(LoadMode::Copy);
+        REQUIRE(processor.readPGM<false>("output/test_stats.pgm"));
+        int extracted = processor.extractComponents(128, 1, LabelingEngine::UnionFind);
+        processor.filterComponentsBySize(1, 1);
+        REQUIRE(processor.writeComponents<bool>("output/test_stats_out"));
+
+        const ProcessingStats & stats = processor.getStats();
+        REQUIRE(stats.getPhase(Phase::Read).calls == 1);
+        REQUIRE(stats.getPhase(Phase::Read).bytes == pixelCount);
+        REQUIRE(stats.getPhase(Phase::Read).pixels == pixelCount);
+        REQUIRE(stats.getPhase(Phase::Threshold).pixels == pixelCount);
+        REQUIRE(stats.getPhase(Phase::Label).calls == 1);
+        REQUIRE(stats.getPhase(Phase::Label).pixels == pixelCount);
+        REQUIRE(stats.getPhase(Phase::Filter).pixels == static_cast<uint64_t>(extracted));
+        REQUIRE(stats.getPhase(Phase::Write).bytes == pixelCount);
+        REQUIRE(stats.getPeakComponents() == static_cast<size_t>(extracted));
+        REQUIRE(stats.getPhase(Phase::Label).seconds >= 0);
+        REQUIRE(ProcessingStats::getPeakMemoryKiB() > 0);
+
+        //counters add up over images until they are reset
+        processor.extractComponents(255, 1);
+        REQUIRE(processor.getStats().getPhase(Phase::Label).calls == 2);
+        processor.resetStats();
+        REQUIRE(processor.getStats().getPhase(Phase::Label).calls == 0);
+        REQUIRE(processor.getStats().getPeakComponents() == 0);
+    }
+
+    SECTION("Merging and JSON"){
+        std::cout << "Testing ProcessingStats: merge and JSON output" << std::endl;
+        ProcessingStats first, second;
+        first.record(Phase::Read, 0.5, 100, 100);
+        first.notePeakComponents(7);
+        second.record(Phase::Read, 0.25, 300, 300);
+        second.notePeakComponents(3);
+        first.merge(second);
+        REQUIRE(first.getPhase(Phase::Read).calls == 2);
+        REQUIRE(first.getPhase(Phase::Read).seconds == Approx(0.75));
+        REQUIRE(first.getPhase(Phase::Read).bytes == 400);
+        REQUIRE(first.getPeakComponents() == 7);
+
+        std::ostringstream json;
+        first.writeJSON(json);
+        std::string text = json.str();
+        REQUIRE(text.front() == '{');
+        REQUIRE(text.back() == '}');
+        REQUIRE(text.find("\"read\": {\"calls\": 2, \"seconds\": 0.750000, \"bytes\": 400, \"pixels\": 400") != std::string::npos);
+        for(const char * name : {"threshold", "label", "filter", "write", "peak_components\": 7", "peak_memory_kib"}){
+            REQUIRE(text.find(name) != std::string::npos);
+        }
+        REQUIRE(std::count(text.begin(), text.end(), '{') == std::count(text.begin(), text.end(), '}'));
+    }
+
+    SECTION("Batch stats cover every file"){
+        std::cout << "Testing ProcessingStats: batch totals" << std::endl;
+        BatchOptions options;
+        BatchProcessor batch(options, 2, 1);
+        batch.run({"output/test_stats.pgm", "output/test_stats.pgm", "output/test_stats.pgm"}, [](const BatchResult &){});
+        REQUIRE(batch.getStats().getPhase(Phase::Read).calls == 3);
+        REQUIRE(batch.getStats().getPhase(Phase::Label).pixels == 3 * pixelCount);
+        REQUIRE(batch.getStats().getPeakComponents() == pixelCount / 2);
+    }
+}
+
+TEST_CASE("GreyConverter TEST"){
+    SECTION("Fixed-point grey is within the documented bound of the floating point formula"){
+        std::cout << "Testing GreyConverter: difference from the floating point formula" << std::endl;
+        //every colour, one red level at a time
+        std::vector<unsigned char> colour(256 * 256 * 3), grey(256 * 256);
+        int largestDifference = 0;
+        size_t differentCount = 0;
+        for(int red = 0; red < 256; ++red){
+            for(int i = 0; i < 256 * 256; ++i){
+                colour[i*3] = static_cast<unsigned char>(red);
+                colour[i*3 + 1] = static_cast<unsigned char>(i >> 8);
+                colour[i*3 + 2] = static_cast<unsigned char>(i & 0xFF);
+            }
+            GreyConverter::convert(colour.data(), grey.data(), grey.size());
+            for(int i = 0; i < 256 * 256; ++i){
+                int expected = static_cast<int>(0.299 * red + 0.587 * (i >> 8) + 0.114 * (i & 0xFF));
+                int difference = std::abs(grey[i] - expected);
+                largestDifference = std::max(largestDifference, difference);
+                differentCount += (difference != 0);
+            }
+        }
+        REQUIRE(largestDifference == GreyConverter::maxFloatDifference);
+        //pins how often the two formulas disagree (13.4% of colours), so a change of weights or rounding is noticed
+        REQUIRE(differentCount == 2243405);
+        REQUIRE(GreyConverter::greyLevel(255, 255, 255) == 255);
+        REQUIRE(GreyConverter::greyLevel(0, 0, 0) == 0);
+    }
+
+    SECTION("Every kernel matches greyLevel"){
+        std::cout << "Testing GreyConverter: kernels" << std::endl;
+        //an odd length leaves a tail for the scalar loop
+        const size_t count = 1000 * 16 + 7;
+        std::vector<unsigned char> colour(count * 3);
+        std::mt19937 random(3);
+        for(unsigned char & value : colour){
+            value = static_cast<unsigned char>(random() & 0xFF);
+        }
+        std::vector<unsigned char> expected(count);
+        for(size_t i = 0; i < count; ++i){
+            expected[i] = GreyConverter::greyLevel(colour[i*3], colour[i*3 + 1], colour[i*3 + 2]);
+        }
+        for(ConversionKernel kernel : {ConversionKernel::Scalar, ConversionKernel::SSSE3}){
+            std::vector<unsigned char> grey(count, 0);
+            GreyConverter::convert(colour.data(), grey.data(), count, kernel);
+            REQUIRE(grey == expected);
+        }
+    }
+
+    SECTION("Every PPM reader converts with the same kernel"){
+        std::cout << "Testing GreyConverter: PPM readers" << std::endl;
+        std::ifstream in("input/Chess_Colours.ppm", std::ios::binary);
+        std::string magicNumber;
+        int width, height, maxVal;
+        REQUIRE(PGMimageProcessor::readHeader(in, magicNumber, width, height, maxVal));
+        std::vector<unsigned char> colour(static_cast<size_t>(width) * height * 3);
+        in.read(reinterpret_cast<char *>(colour.data()), colour.size());
+        REQUIRE(in);
+
+        PGMimageProcessor copied, mapped;
+        copied.setLoadMode(LoadMode::Copy);
+        mapped.setLoadMode(LoadMode::Map);
+        REQUIRE(copied.readPGM<true>("input/Chess_Colours.ppm"));
+        REQUIRE(mapped.readPGM<true>("input/Chess_Colours.ppm"));
+        size_t mismatches = 0;
+        for(size_t i = 0; i < colour.size() / 3; ++i){
+            unsigned char expected = GreyConverter::greyLevel(colour[i*3], colour[i*3 + 1], colour[i*3 + 2]);
+            mismatches += (copied.getImageData()[i] != expected) + (mapped.getImageData()[i] != expected);
+        }
+        REQUIRE(mismatches == 0);
+    }
+}
+
+TEST_CASE("Component statistics TEST"){
+    //sums every statistic again from the pixel list, the way callers had to before
+    auto bruteForce = [](const ConnectedComponent & component, const unsigned char * image, int width){
+        ConnectedComponent::Statistics statistics;
+        for(const std::pair<int, int> & pixel : component.getPixels()){
+            statistics.addPixel(pixel.first, pixel.second);
+            statistics.addIntensity(image[static_cast<size_t>(pixel.second)*width + pixel.first]);
+        }
+        return statistics;
+    };
+    auto sameStatistics = [](const ConnectedComponent::Statistics & a, const ConnectedComponent::Statistics & b){
+        return a.sumX == b.sumX && a.sumY == b.sumY && a.sumXX == b.sumXX && a.sumYY == b.sumYY && a.sumXY == b.sumXY
+            && a.sumIntensity == b.sumIntensity && a.minIntensity == b.minIntensity && a.maxIntensity == b.maxIntensity;
+    };
+
+    const int width = 300, height = 200;
+    REQUIRE(ImageGenerator::writePGM("output/test_statistics.pgm", ImageGenerator::generate(SyntheticPattern::Noise, width, height, 11), width, height));
+
+    SECTION("Every engine accumulates the same sums as the pixels"){
+        std::cout << "Testing component statistics: engines" << std::endl;
+        for(int connectivity : {4, 8}){
+            for(LabelingEngine engine : {LabelingEngine::BFS, LabelingEngine::UnionFind, LabelingEngine::RunLength}){
+                PGMimageProcessor processor;
+                processor.setThreadCount(engine == LabelingEngine::UnionFind ? 3 : 1);
+                REQUIRE(processor.readPGM<false>("output/test_statistics.pgm"));
+                REQUIRE(processor.extractComponents(128, 1, engine, connectivity) > 0);
+
+                size_t mismatches = 0;
+                for(const ConnectedComponent & component : processor.getComponents()){
+                    mismatches += !sameStatistics(component.getStatistics(), bruteForce(component, processor.getImageData(), width));
+                    mismatches += !component.hasIntensity() || component.getMinIntensity() < 128;
+                }
+                REQUIRE(mismatches == 0);
+            }
+        }
+    }
+
+    SECTION("Streamed components carry the same sums"){
+        std::cout << "Testing component statistics: StreamingExtractor" << std::endl;
+        PGMimageProcessor processor;
+        REQUIRE(processor.readPGM<false>("output/test_statistics.pgm"));
+        StreamingExtractor extractor(7);
+        size_t mismatches = 0;
+        REQUIRE(extractor.extract("output/test_statistics.pgm", 128, 1, [&](ConnectedComponent component){
+            mismatches += !sameStatistics(component.getStatistics(), bruteForce(component, processor.getImageData(), width));
+        }) > 0);
+        REQUIRE(mismatches == 0);
+    }
+
+    SECTION("Shape measures of known shapes"){
+        std::cout << "Testing component statistics: centroid, orientation and eccentricity" << std::endl;
+        ConnectedComponent line(0);
+        line.addRun(5, 10, 29);
+        REQUIRE(line.getCentroid().first == Approx(19.5));
+        REQUIRE(line.getCentroid().second == Approx(5.0));
+        REQUIRE(line.getOrientation() == Approx(0.0));
+        REQUIRE(line.getEccentricity() == Approx(1.0));
+
+        ConnectedComponent column(1);
+        for(int y = 0; y < 20; ++y){
+            column.addPixel(3, y);
+        }
+        REQUIRE(std::abs(column.getOrientation()) == Approx(M_PI / 2));
+        REQUIRE(column.getEccentricity() == Approx(1.0));
+
+        //a square has equal variances and no covariance, so it is not elongated in any direction
+        std::vector<ConnectedComponent::Run> squareRuns;
+        for(int y = 100; y < 110; ++y){
+            squareRuns.push_back({y, 1000, 1009});
+        }
+        ConnectedComponent square(2, squareRuns);
+        auto [mu20, mu02, mu11] = square.getSecondMoments();
+        REQUIRE(mu20 == Approx(8.25)); //variance of 10 consecutive integers
+        REQUIRE(mu02 == Approx(8.25));
+        REQUIRE(mu11 == Approx(0.0).margin(1e-12));
+        REQUIRE(square.getEccentricity() == Approx(0.0).margin(1e-6));
+
+        //a diagonal line of pixels points down and to the right, at 45 degrees
+        ConnectedComponent diagonal(3);
+        for(int i = 0; i < 10; ++i){
+            diagonal.addPixel(i, i);
+        }
+        REQUIRE(diagonal.getOrientation() == Approx(M_PI / 4));
+
+        //without the original image there is no intensity
+        REQUIRE(!square.hasIntensity());
+        REQUIRE(square.getMeanIntensity() == 0);
+
+        ConnectedComponent single(4, std::vector<std::pair<int, int>>{{7, 9}});
+        REQUIRE(single.getEccentricity() == 0);
+        REQUIRE(single.getCentroid() == std::make_pair(7.0, 9.0));
+    }
+
+    SECTION("Statistics survive copies and moves"){
+        std::cout << "Testing component statistics: Big 6" << std::endl;
+        PGMimageProcessor processor;
+        REQUIRE(processor.readPGM<false>("output/test_statistics.pgm"));
+        processor.extractComponents(128, 20, LabelingEngine::RunLength);
+        REQUIRE(processor.getComponentCount() > 0);
+        ConnectedComponent copy = processor.getComponents()[0];
+        REQUIRE(copy.getMeanIntensity() == processor.getComponents()[0].getMeanIntensity());
+        ConnectedComponent moved = std::move(copy);
+        REQUIRE(moved.hasIntensity());
+        REQUIRE(!copy.hasIntensity());
+        REQUIRE(copy.getStatistics().sumX == 0);
+    }
+}
+
+TEST_CASE("Size index TEST"){
+    PGMimageProcessor processor;
+    REQUIRE(ImageGenerator::writePGM("output/test_size_index.pgm", ImageGenerator::generate(SyntheticPattern::Noise, 200, 150, 5), 200, 150));
+    REQUIRE(processor.readPGM<false>("output/test_size_index.pgm"));
+    int extracted = processor.extractComponents(128, 1, LabelingEngine::RunLength);
+    REQUIRE(extracted > 100);
+
+    SECTION("Range queries match filterComponentsBySize without removing components"){
+        std::cout << "Testing the size index: range queries" << std::endl;
+        for(std::pair<int, int> range : {std::make_pair(1, 1), std::make_pair(3, 10), std::make_pair(20, 1000000), std::make_pair(5, 4)}){
+            ComponentView view = processor.getComponentsBySize(range.first, range.second);
+
+            std::vector<int> viewIDs;
+            int previousSize = std::numeric_limits<int>::max();
+            bool sorted = true;
+            for(const ConnectedComponent & component : view){
+                viewIDs.push_back(component.getID());
+                sorted = sorted && component.getSize() <= previousSize;
+                previousSize = component.getSize();
+            }
+            REQUIRE(sorted);
+            REQUIRE(processor.getComponentCount() == extracted);
+
+            PGMimageProcessor filtered(processor);
+            filtered.filterComponentsBySize(range.first, range.second);
+            std::vector<int> filteredIDs;
+            for(const ConnectedComponent & component : filtered.getComponents()){
+                filteredIDs.push_back(component.getID());
+            }
+            std::sort(viewIDs.begin(), viewIDs.end());
+            REQUIRE(viewIDs == filteredIDs);
+            REQUIRE(view.size() == filteredIDs.size());
+        }
+    }
+
+    SECTION("Largest, smallest and top-K"){
+        std::cout << "Testing the size index: largest, smallest and top-K" << std::endl;
+        std::vector<int> sizes;
+        for(const ConnectedComponent & component : processor.getComponents()){
+            sizes.push_back(component.getSize());
+        }
+        std::sort(sizes.rbegin(), sizes.rend());
+        REQUIRE(processor.getLargestSize() == sizes.front());
+        REQUIRE(processor.getSmallestSize() == sizes.back());
+
+        ComponentView top = processor.getLargestComponents(5);
+        REQUIRE(top.size() == 5);
+        int rank = 0;
+        for(const ConnectedComponent & component : top){
+            REQUIRE(component.getSize() == sizes[rank++]);
+        }
+        REQUIRE(processor.getLargestComponents(extracted + 10).size() == static_cast<size_t>(extracted));
+        REQUIRE(processor.getLargestComponents(0).empty());
+    }
+
+    SECTION("The index follows the components"){
+        std::cout << "Testing the size index: rebuilt after the components change" << std::endl;
+        REQUIRE(processor.getComponentsBySize(1, 1).size() > 0);
+        processor.filterComponentsBySize(2, 1000000);
+        REQUIRE(processor.getComponentsBySize(1, 1).empty());
+        processor.extractComponents(200, 1);
+        int largest = 0;
+        for(const ConnectedComponent & component : processor.getComponents()){
+            largest = std::max(largest, component.getSize());
+        }
+        REQUIRE(processor.getLargestSize() == largest);
+        REQUIRE((*processor.getLargestComponents(1).begin()).getSize() == largest);
+        REQUIRE(processor.getComponentsBySize(1, 1000000).size() == static_cast<size_t>(processor.getComponentCount()));
+
+        PGMimageProcessor empty;
+        REQUIRE(empty.getLargestSize() == 0);
+        REQUIRE(empty.getSmallestSize() == 0);
+        REQUIRE(empty.getComponentsBySize(1, 10).empty());
+    }
+}
+
+TEST_CASE("Labeling workspace TEST"){
+    /**
+     * Checks that two processors hold identical component lists, down to the order of the pixels and the sums
+     */
+    auto requireIdentical = [](const PGMimageProcessor & expected, const PGMimageProcessor & actual){
+        std::span<const ConnectedComponent> expectedComponents = expected.getComponents();
+        std::span<const ConnectedComponent> actualComponents = actual.getComponents();
+        REQUIRE(expectedComponents.size() == actualComponents.size());
+        for(size_t i = 0; i < expectedComponents.size(); ++i){
+            REQUIRE(expectedComponents[i].getID() == actualComponents[i].getID());
+            REQUIRE(expectedComponents[i].getBoundingBox() == actualComponents[i].getBoundingBox());
+            REQUIRE(expectedComponents[i].getPixels() == actualComponents[i].getPixels());
+            REQUIRE(expectedComponents[i].getStatistics().sumXY == actualComponents[i].getStatistics().sumXY);
+            REQUIRE(expectedComponents[i].getStatistics().sumIntensity == actualComponents[i].getStatistics().sumIntensity);
+        }
+    };
+
+    //frames of different sizes and contents, so stale labels or sums left in a reused buffer would show up
+    std::vector< std::tuple<SyntheticPattern, int, int> > frames = {
+        {SyntheticPattern::Noise, 120, 90}, {SyntheticPattern::Blobs, 200, 150}, {SyntheticPattern::Spiral, 64, 64},
+        {SyntheticPattern::Noise, 200, 150}, {SyntheticPattern::Checkerboard, 33, 17}, {SyntheticPattern::Blobs, 120, 90}
+    };
+
+    SECTION("A reused processor labels every frame like a new one"){
+        std::cout << "Testing the labeling workspace: frames of different sizes through one processor" << std::endl;
+        for(LabelingEngine engine : {LabelingEngine::BFS, LabelingEngine::UnionFind, LabelingEngine::RunLength}){
+            for(int connectivity : {4, 8}){
+                PGMimageProcessor reused;
+                reused.setThreadCount(engine == LabelingEngine::UnionFind ? 3 : 1);
+                for(size_t f = 0; f < frames.size(); ++f){
+                    auto [pattern, width, height] = frames[f];
+                    std::vector<unsigned char> image = ImageGenerator::generate(pattern, width, height, f + 1);
+                    REQUIRE(reused.reset(image, width, height));
+                    reused.extractComponents(128, 1 + static_cast<int>(f % 3), engine, connectivity);
+
+                    PGMimageProcessor fresh;
+                    fresh.setThreadCount(reused.getThreadCount());
+                    REQUIRE(fresh.reset(image, width, height));
+                    fresh.extractComponents(128, 1 + static_cast<int>(f % 3), engine, connectivity);
+                    requireIdentical(fresh, reused);
+                }
+            }
+        }
+    }
+
+    SECTION("reset replaces the image"){
+        std::cout << "Testing the labeling workspace: reset" << std::endl;
+        PGMimageProcessor fromFile;
+        REQUIRE(ImageGenerator::writePGM("output/test_workspace.pgm", ImageGenerator::generate(SyntheticPattern::Blobs, 200, 150, 7), 200, 150));
+        REQUIRE(fromFile.readPGM<false>("output/test_workspace.pgm"));
+        fromFile.extractComponents(128, 1);
+
+        PGMimageProcessor processor;
+        std::vector<unsigned char> spiral = ImageGenerator::generate(SyntheticPattern::Spiral, 300, 300, 1);
+        REQUIRE(processor.reset(spiral, 300, 300));
+        processor.extractComponents(128, 1);
+        REQUIRE(processor.getComponentCount() > 0);
+        processor.getLabelImage();
+
+        std::vector<unsigned char> blobs = ImageGenerator::generate(SyntheticPattern::Blobs, 200, 150, 7);
+        REQUIRE(processor.reset(blobs, 200, 150));
+        REQUIRE(processor.getWidth() == 200);
+        REQUIRE(processor.getHeight() == 150);
+        REQUIRE(processor.getComponentCount() == 0);
+        REQUIRE(std::equal(blobs.begin(), blobs.end(), processor.getImageData()));
+        REQUIRE(processor.getHistogram() == fromFile.getHistogram());
+
+        processor.extractComponents(128, 1);
+        requireIdentical(fromFile, processor);
+        REQUIRE(processor.getLabelImage().getWidth() == 200);
+
+        //the dimensions must match the number of pixels, and a rejected image leaves the current one in place
+        REQUIRE_FALSE(processor.reset(blobs, 100, 150));
+        REQUIRE_FALSE(processor.reset(blobs, 0, 0));
+        REQUIRE(processor.getWidth() == 200);
+        REQUIRE(processor.getComponentCount() == fromFile.getComponentCount());
+    }
+
+    SECTION("Released and copied workspaces"){
+        std::cout << "Testing the labeling workspace: release and copies" << std::endl;
+        std::vector<unsigned char> noise = ImageGenerator::generate(SyntheticPattern::Noise, 150, 100, 3);
+        PGMimageProcessor processor;
+        REQUIRE(processor.reset(noise, 150, 100));
+        processor.extractComponents(128, 1, LabelingEngine::UnionFind);
+        PGMimageProcessor expected(processor);
+
+        processor.releaseWorkspace();
+        processor.extractComponents(128, 1, LabelingEngine::UnionFind);
+        requireIdentical(expected, processor);
+
+        PGMimageProcessor copy(processor);
+        copy.extractComponents(128, 1, LabelingEngine::UnionFind);
+        requireIdentical(expected, copy);
+
+        PGMimageProcessor moved(std::move(copy));
+        moved.extractComponents(128, 1, LabelingEngine::RunLength);
+        REQUIRE(moved.getComponentCount() == expected.getComponentCount());
+    }
+}
+
+TEST_CASE("ComponentArena TEST"){
+    SECTION("Allocations are aligned and do not overlap"){
+        std::cout << "Testing ComponentArena: allocation" << std::endl;
+        ComponentArena arena;
+        REQUIRE(arena.getBlockCount() == 0);
+
+        std::vector< std::pair<unsigned char *, size_t> > allocations;
+        for(size_t i = 1; i <= 200; ++i){
+            size_t alignment = size_t(1) << (i % 6); //1 to 32
+            size_t bytes = (i * 37) % 3000;
+            unsigned char * memory = static_cast<unsigned char *>(arena.allocate(bytes, alignment));
+            REQUIRE(reinterpret_cast<std::uintptr_t>(memory) % alignment == 0);
+            std::memset(memory, static_cast<int>(i), bytes);
+            allocations.push_back({memory, bytes});
+        }
+        //every allocation still holds what was written to it, so none overlap
+        for(size_t i = 0; i < allocations.size(); ++i){
+            REQUIRE(std::all_of(allocations[i].first, allocations[i].first + allocations[i].second,
+                                [i](unsigned char value){ return value == static_cast<unsigned char>(i + 1); }));
+        }
+        REQUIRE(arena.getBlockCount() > 1);
+        REQUIRE(arena.getAllocated() <= arena.getCapacity());
+
+        //a block larger than the first one is started for a large allocation
+        void * large = arena.allocate(ComponentArena::initialBlockSize * 3, 8);
+        REQUIRE(large != nullptr);
+    }
+
+    SECTION("reset keeps one block as large as every block before"){
+        std::cout << "Testing ComponentArena: reset and release" << std::endl;
+        ComponentArena arena;
+        for(int i = 0; i < 100; ++i){
+            REQUIRE(arena.allocate(4000, 8) != nullptr);
+        }
+        size_t capacity = arena.getCapacity();
+        REQUIRE(arena.getBlockCount() > 1);
+
+        arena.reset();
+        REQUIRE(arena.getBlockCount() == 1);
+        REQUIRE(arena.getCapacity() == capacity);
+        REQUIRE(arena.getAllocated() == 0);
+
+        //the same allocations fit in the merged block
+        for(int i = 0; i < 100; ++i){
+            REQUIRE(arena.allocate(4000, 8) != nullptr);
+        }
+        REQUIRE(arena.getBlockCount() == 1);
+
+        arena.release();
+        REQUIRE(arena.getBlockCount() == 0);
+        REQUIRE(arena.getCapacity() == 0);
+    }
+
+    SECTION("Component lists live in the processor's arena"){
+        std::cout << "Testing ComponentArena: components of a processor" << std::endl;
+        std::vector<unsigned char> blobs = ImageGenerator::generate(SyntheticPattern::Blobs, 300, 200, 9);
+        std::vector<ConnectedComponent> copies;
+        std::vector< std::vector< std::pair<int, int> > > expectedPixels;
+        PGMimageProcessor moved;
+        {
+            PGMimageProcessor processor;
+            REQUIRE(processor.reset(blobs, 300, 200));
+            processor.extractComponents(128, 1, LabelingEngine::UnionFind);
+            REQUIRE(processor.getComponentCount() > 2);
+            for(const ConnectedComponent & component : processor.getComponents()){
+                REQUIRE(component.getPixels().get_allocator().resource() != std::pmr::get_default_resource());
+                copies.push_back(component);
+                expectedPixels.emplace_back(component.getPixels().begin(), component.getPixels().end());
+            }
+            //copies are on the default heap
+            REQUIRE(copies[0].getPixels().get_allocator().resource() == std::pmr::get_default_resource());
+
+            //labeling again reuses the arena, and filtering moves components within it
+            processor.extractComponents(128, 1, LabelingEngine::BFS);
+            processor.extractComponents(128, 1, LabelingEngine::UnionFind);
+            processor.filterComponentsBySize(static_cast<int>(expectedPixels[1].size()), std::numeric_limits<int>::max());
+            moved = std::move(processor);
+        }
+
+        //the arena moved with the components, so they are intact after the processor they came from is gone
+        for(const ConnectedComponent & component : moved.getComponents()){
+            std::vector< std::pair<int, int> > pixels(component.getPixels().begin(), component.getPixels().end());
+            REQUIRE(pixels == expectedPixels[component.getID()]);
+        }
+        for(size_t i = 0; i < copies.size(); ++i){
+            std::vector< std::pair<int, int> > pixels(copies[i].getPixels().begin(), copies[i].getPixels().end());
+            REQUIRE(pixels == expectedPixels[i]);
+        }
+
+        //run lists are in the arena too, the pixels expanded from them are not
+        moved.extractComponents(128, 1, LabelingEngine::RunLength);
+        const ConnectedComponent & first = moved.getComponents()[0];
+        REQUIRE(first.getRuns().get_allocator().resource() != std::pmr::get_default_resource());
+        REQUIRE(first.getPixels().get_allocator().resource() == std::pmr::get_default_resource());
+        REQUIRE(std::vector< std::pair<int, int> >(first.getPixels().begin(), first.getPixels().end()) == expectedPixels[0]);
+    }
+}
+
+TEST_CASE("Component output TEST"){
+    /**
+     * Reads the raster of a PGM or PPM written by writeComponents
+     */
+    auto readRaster = [](const std::string & fileName, int channels){
+        std::ifstream in(fileName, std::ios::binary);
+        std::string magicNumber;
+        int width = 0, height = 0, maxVal = 0;
+        REQUIRE(PGMimageProcessor::readHeader(in, magicNumber, width, height, maxVal));
+        std::vector<unsigned char> raster(static_cast<size_t>(width) * height * channels);
+        in.read(reinterpret_cast<char *>(raster.data()), raster.size());
+        REQUIRE(in.gcount() == static_cast<std::streamsize>(raster.size()));
+        return raster;
+    };
+
+    std::vector<unsigned char> noise = ImageGenerator::generate(SyntheticPattern::Noise, 173, 91, 4);
+
+    SECTION("Every engine writes exactly the pixels of the kept components"){
+        std::cout << "Testing the component output: PGM and PPM rasters against the label image" << std::endl;
+        for(LabelingEngine engine : {LabelingEngine::BFS, LabelingEngine::UnionFind, LabelingEngine::RunLength}){
+            PGMimageProcessor processor;
+            REQUIRE(processor.reset(noise, 173, 91));
+            processor.extractComponents(128, 1, engine, 8);
+            processor.filterComponentsBySize(3, 1000);
+
+            std::vector<unsigned char> expected(noise.size());
+            for(int y = 0; y < 91; ++y){
+                for(int x = 0; x < 173; ++x){
+                    expected[static_cast<size_t>(y)*173 + x] = processor.getLabelAt(x, y) >= 0 ? 255 : 0;
+                }
+            }
+
+            REQUIRE(processor.writeComponents<bool>("output/test_component_output"));
+            REQUIRE(readRaster("output/test_component_output.pgm", 1) == expected);
+
+            REQUIRE(processor.writeComponents<bool, false>("output/test_component_output"));
+            std::vector<unsigned char> colour = readRaster("output/test_component_output.ppm", 3);
+            bool grey = true;
+            for(size_t i = 0; i < expected.size(); ++i){
+                grey = grey && colour[i*3] == expected[i] && colour[i*3 + 1] == expected[i] && colour[i*3 + 2] == expected[i];
+            }
+            REQUIRE(grey);
+        }
+    }
+
+    SECTION("Outputs written in several bands match the components"){
+        std::cout << "Testing the component output: images larger than one write band" << std::endl;
+        const int width = 2100, height = 2100; //the PGM takes two bands, the PPM four
+        REQUIRE(static_cast<size_t>(width) * height > PGMimageProcessor::writeBandSize);
+        for(SyntheticPattern pattern : {SyntheticPattern::Noise, SyntheticPattern::Spiral}){
+            std::vector<unsigned char> image = ImageGenerator::generate(pattern, width, height, 5);
+            for(LabelingEngine engine : {LabelingEngine::BFS, LabelingEngine::UnionFind, LabelingEngine::RunLength}){
+                PGMimageProcessor processor;
+                REQUIRE(processor.reset(image, width, height));
+                processor.extractComponents(128, 2, engine);
+
+                std::vector<unsigned char> expected(image.size());
+                for(int y = 0; y < height; ++y){
+                    for(int x = 0; x < width; ++x){
+                        expected[static_cast<size_t>(y)*width + x] = processor.getLabelAt(x, y) >= 0 ? 255 : 0;
+                    }
+                }
+                REQUIRE(processor.writeComponents<bool>("output/test_component_bands"));
+                REQUIRE(readRaster("output/test_component_bands.pgm", 1) == expected);
+
+                REQUIRE(processor.writeComponents<bool, false>("output/test_component_bands"));
+                std::vector<unsigned char> colour = readRaster("output/test_component_bands.ppm", 3);
+                bool grey = true;
+                for(size_t i = 0; i < expected.size(); ++i){
+                    grey = grey && colour[i*3] == expected[i] && colour[i*3 + 1] == expected[i] && colour[i*3 + 2] == expected[i];
+                }
+                REQUIRE(grey);
+            }
+        }
+
+        //bounding boxes that cross the edges of the bands
+        std::vector<unsigned char> blobs = ImageGenerator::generate(SyntheticPattern::Blobs, width, height, 6);
+        PGMimageProcessor processor;
+        REQUIRE(processor.reset(blobs, width, height));
+        processor.extractComponents(128, 1);
+        std::vector<unsigned char> expected(blobs.size() * 3);
+        for(size_t i = 0; i < blobs.size(); ++i){
+            expected[i*3] = expected[i*3 + 1] = expected[i*3 + 2] = blobs[i];
+        }
+        auto setRed = [&](int x, int y){
+            size_t i = static_cast<size_t>(y)*width + x;
+            expected[i*3] = 255;
+            expected[i*3 + 1] = expected[i*3 + 2] = 0;
+        };
+        for(const ConnectedComponent & component : processor.getComponents()){
+            for(int x = component.getXMin(); x <= component.getXMax(); ++x){
+                setRed(x, component.getYMin());
+                setRed(x, component.getYMax());
+            }
+            for(int y = component.getYMin(); y <= component.getYMax(); ++y){
+                setRed(component.getXMin(), y);
+                setRed(component.getXMax(), y);
+            }
+        }
+        REQUIRE(processor.writeComponents<bool, true>("output/test_component_bands"));
+        REQUIRE(readRaster("output/test_component_bands.ppm", 3) == expected);
+    }
+
+    SECTION("Outputs rendered by several threads match a single thread"){
+        std::cout << "Testing the component output: bands split between threads" << std::endl;
+        auto writeAll = [&](PGMimageProcessor & processor, int threads){
+            processor.setThreadCount(threads);
+            REQUIRE(processor.writeComponents<bool>("output/test_component_threads"));
+            REQUIRE(processor.writeComponents<bool, false>("output/test_component_threads"));
+            std::vector<unsigned char> written = readRaster("output/test_component_threads.pgm", 1);
+            std::vector<unsigned char> colour = readRaster("output/test_component_threads.ppm", 3);
+            REQUIRE(processor.writeComponents<bool, true>("output/test_component_threads"));
+            std::vector<unsigned char> boxes = readRaster("output/test_component_threads.ppm", 3);
+            written.insert(written.end(), colour.begin(), colour.end());
+            written.insert(written.end(), boxes.begin(), boxes.end());
+            return written;
+        };
+        //a tall image that takes several bands, and a short one with fewer rows than threads
+        for(auto [width, height] : {std::pair<int, int>(1500, 3000), std::pair<int, int>(300, 5)}){
+            for(SyntheticPattern pattern : {SyntheticPattern::Noise, SyntheticPattern::Blobs, SyntheticPattern::Spiral}){
+                std::vector<unsigned char> image = ImageGenerator::generate(pattern, width, height, 7);
+                for(LabelingEngine engine : {LabelingEngine::BFS, LabelingEngine::UnionFind, LabelingEngine::RunLength}){
+                    PGMimageProcessor processor;
+                    REQUIRE(processor.reset(image, width, height));
+                    processor.extractComponents(128, 1, engine);
+                    processor.filterComponentsBySize(3, width * height);
+                    std::vector<unsigned char> single = writeAll(processor, 1);
+                    REQUIRE(writeAll(processor, 3) == single);
+                    REQUIRE(writeAll(processor, 8) == single);
+                }
+            }
+        }
+    }
+
+    SECTION("The bounding box output keeps the original pixels inside the boxes"){
+        std::cout << "Testing the component output: bounding box PPM" << std::endl;
+        PGMimageProcessor processor;
+        std::vector<unsigned char> blobs = ImageGenerator::generate(SyntheticPattern::Blobs, 120, 80, 2);
+        REQUIRE(processor.reset(blobs, 120, 80));
+        processor.extractComponents(128, 1, LabelingEngine::RunLength);
+        REQUIRE(processor.getComponentCount() > 0);
+        REQUIRE(processor.writeComponents<bool, true>("output/test_component_boxes"));
+        std::vector<unsigned char> colour = readRaster("output/test_component_boxes.ppm", 3);
+
+        //off the box outlines every pixel is the grey level of the input
+        std::vector<bool> outline(blobs.size(), false);
+        for(const ConnectedComponent & component : processor.getComponents()){
+            for(int x = component.getXMin(); x <= component.getXMax(); ++x){
+                outline[static_cast<size_t>(component.getYMin())*120 + x] = outline[static_cast<size_t>(component.getYMax())*120 + x] = true;
+            }
+            for(int y = component.getYMin(); y <= component.getYMax(); ++y){
+                outline[static_cast<size_t>(y)*120 + component.getXMin()] = outline[static_cast<size_t>(y)*120 + component.getXMax()] = true;
+            }
+        }
+        bool matches = true;
+        for(size_t i = 0; i < blobs.size(); ++i){
+            if(outline[i]){
+                matches = matches && colour[i*3] == 255 && colour[i*3 + 1] == 0 && colour[i*3 + 2] == 0;
+            }else{
+                matches = matches && colour[i*3] == blobs[i] && colour[i*3 + 1] == blobs[i] && colour[i*3 + 2] == blobs[i];
+            }
+        }
+        REQUIRE(matches);
+    }
+}
+
+TEST_CASE("Logger TEST"){
+    std::ostringstream sink;
+    //sends the lines back to std::cout at the default verbosity even if a section fails, before sink is destroyed
+    struct RestoreLogger{
+        ~RestoreLogger(){
+            Logger::setSink(std::cout);
+            Logger::setVerbosity(Verbosity::Normal);
+        }
+    } restore;
+    Logger::setSink(sink);
+
+    SECTION("Only the lines of enabled levels are written"){
+        std::cout << "Testing Logger: verbosity" << std::endl;
+        Logger::setVerbosity(Verbosity::Quiet);
+        REQUIRE(Logger::isEnabled(Verbosity::Quiet));
+        REQUIRE_FALSE(Logger::isEnabled(Verbosity::Normal));
+        Logger::log(Verbosity::Quiet, "result ", 1);
+        Logger::log(Verbosity::Normal, "status ", 2);
+        Logger::log(Verbosity::Verbose, "detail ", 3);
+
+        Logger::setVerbosity(Verbosity::Verbose);
+        REQUIRE(Logger::getVerbosity() == Verbosity::Verbose);
+        Logger::log(Verbosity::Verbose, "detail ", 4);
+        Logger::flush();
+        REQUIRE(sink.str() == "result 1\ndetail 4\n");
+    }
+
+    SECTION("Lines are buffered until the buffer fills up or is flushed"){
+        std::cout << "Testing Logger: buffering" << std::endl;
+        Logger::log(Verbosity::Normal, "first line");
+        REQUIRE(sink.str().empty());
+
+        const std::string line(99, 'x'); //100 bytes with the newline
+        size_t lines = Logger::bufferSize / 100 + 1;
+        for(size_t i = 0; i < lines; ++i){
+            Logger::log(Verbosity::Normal, line);
+        }
+        //the buffer was handed over whole once it reached bufferSize
+        REQUIRE(sink.str().size() >= Logger::bufferSize);
+        REQUIRE(sink.str().rfind("first line\n", 0) == 0);
+
+        Logger::log(Verbosity::Normal, "last line");
+        Logger::flush();
+        REQUIRE(sink.str().size() == 11 + lines * 100 + 10);
+        REQUIRE(sink.str().ends_with("\nlast line\n"));
+    }
+
+    SECTION("Each line starts with the default formatting"){
+        std::cout << "Testing Logger: formatting" << std::endl;
+        Logger::log(Verbosity::Normal, std::fixed, std::setprecision(1), 2.25, " ", std::hex, 255);
+        Logger::log(Verbosity::Normal, 0.5, " ", 255);
+        Logger::flush();
+        REQUIRE(sink.str() == "2.2 ff\n0.5 255\n");
+    }
+
+    SECTION("Lines logged from several threads are not interleaved"){
+        std::cout << "Testing Logger: threads" << std::endl;
+        const int threads = 4, linesPerThread = 2000;
+        std::vector<std::thread> workers;
+        for(int t = 0; t < threads; ++t){
+            workers.emplace_back([t](){
+                for(int i = 0; i < linesPerThread; ++i){
+                    Logger::log(Verbosity::Normal, "thread ", t, " line ", i);
+                }
+            });
+        }
+        for(std::thread & worker : workers){
+            worker.join();
+        }
+        Logger::flush();
+
+        //every line is whole, and the lines of each thread are in order
+        std::istringstream lines(sink.str());
+        std::vector<int> next(threads, 0);
+        std::string text;
+        int count = 0;
+        while(std::getline(lines, text)){
+            int t = -1, i = -1;
+            REQUIRE(std::sscanf(text.c_str(), "thread %d line %d", &t, &i) == 2);
+            REQUIRE(text == "thread " + std::to_string(t) + " line " + std::to_string(i));
+            REQUIRE(i == next[t]++);
+            count++;
+        }
+        REQUIRE(count == threads * linesPerThread);
+    }
+
+    SECTION("The bounding boxes of writeComponents are only logged when verbose"){
+        std::cout << "Testing Logger: writeComponents diagnostics" << std::endl;
+        std::vector<unsigned char> image = ImageGenerator::generate(SyntheticPattern::Blobs, 200, 150, 3);
+        PGMimageProcessor processor;
+        REQUIRE(processor.reset(image, 200, 150));
+        int count = processor.extractComponents(128, 1);
+        REQUIRE(count > 0);
+
+        REQUIRE(processor.writeComponents<bool, true>("output/test_logger"));
+        Logger::flush();
+        REQUIRE(sink.str().empty());
+
+        Logger::setVerbosity(Verbosity::Verbose);
+        REQUIRE(processor.writeComponents<bool, true>("output/test_logger"));
+        Logger::flush();
+        std::istringstream lines(sink.str());
+        std::string text;
+        int boxes = 0;
+        while(std::getline(lines, text)){
+            boxes += text.find("bounding box") != std::string::npos;
+        }
+        REQUIRE(boxes == count);
+        REQUIRE(sink.str().ends_with("Data successfully written to output/test_logger.ppm\n"));
+    }
+}
+
+TEST_CASE("ComponentFile TEST"){
+    //the pixels of a component as a sorted list, from whichever list it stores
+    auto pixelSet = [](const ConnectedComponent & component){
+        std::vector< std::pair<int, int> > pixels(component.getPixels().begin(), component.getPixels().end());
+        std::sort(pixels.begin(), pixels.end());
+        return pixels;
+    };
+
+    SECTION("Every engine's components are written and read back in place"){
+        std::cout << "Testing ComponentFile: round trip" << std::endl;
+        std::vector<unsigned char> image = ImageGenerator::generate(SyntheticPattern::Noise, 300, 200, 8);
+        for(LabelingEngine engine : {LabelingEngine::BFS, LabelingEngine::UnionFind, LabelingEngine::RunLength}){
+            PGMimageProcessor processor;
+            REQUIRE(processor.reset(image, 300, 200));
+            processor.extractComponents(128, 1, engine);
+            REQUIRE(processor.writeComponentFile("output/test_components"));
+
+            ComponentFile file;
+            REQUIRE(file.open("output/test_components.ccx"));
+            REQUIRE(file.getWidth() == 300);
+            REQUIRE(file.getHeight() == 200);
+            REQUIRE(file.getComponentCount() == static_cast<size_t>(processor.getComponentCount()));
+
+            bool matches = true;
+            for(const ConnectedComponent & component : processor.getComponents()){
+                const ComponentFile::Record * record = file.findByID(component.getID());
+                REQUIRE(record != nullptr);
+                auto [centroidX, centroidY] = component.getCentroid();
+                matches = matches && record->id == static_cast<uint32_t>(component.getID()) && static_cast<int>(record->size) == component.getSize()
+                    && record->xMin == component.getXMin() && record->yMin == component.getYMin()
+                    && record->xMax == component.getXMax() && record->yMax == component.getYMax()
+                    && record->centroidX == centroidX && record->centroidY == centroidY;
+
+                //the runs are in raster order and hold exactly the component's pixels
+                std::vector< std::pair<int, int> > pixels;
+                const ConnectedComponent::Run * previous = nullptr;
+                for(const ConnectedComponent::Run & run : file.getRuns(*record)){
+                    if(previous){
+                        matches = matches && (previous->y < run.y || (previous->y == run.y && previous->xEnd + 1 < run.xStart));
+                    }
+                    for(int x = run.xStart; x <= run.xEnd; ++x){
+                        pixels.push_back({x, run.y});
+                    }
+                    previous = &run;
+                }
+                std::sort(pixels.begin(), pixels.end());
+                matches = matches && pixels == pixelSet(component);
+            }
+            REQUIRE(matches);
+        }
+    }
+
+    SECTION("The size index matches the processor's"){
+        std::cout << "Testing ComponentFile: size queries" << std::endl;
+        std::vector<unsigned char> image = ImageGenerator::generate(SyntheticPattern::Blobs, 400, 300, 9);
+        PGMimageProcessor processor;
+        REQUIRE(processor.reset(image, 400, 300));
+        processor.extractComponents(100, 1, LabelingEngine::RunLength);
+        REQUIRE(processor.writeComponentFile("output/test_components"));
+        ComponentFile file;
+        REQUIRE(file.open("output/test_components.ccx"));
+        std::span<const ComponentFile::Record> records = file.getRecords();
+
+        auto fileIDs = [&](std::span<const uint32_t> positions){
+            std::vector<int> ids;
+            for(uint32_t position : positions){
+                ids.push_back(records[position].id);
+            }
+            return ids;
+        };
+        auto processorIDs = [](const ComponentView & view){
+            std::vector<int> ids;
+            for(const ConnectedComponent & component : view){
+                ids.push_back(component.getID());
+            }
+            return ids;
+        };
+        int count = processor.getComponentCount();
+        REQUIRE(fileIDs(file.getSizeOrder()) == processorIDs(processor.getLargestComponents(count)));
+        for(auto [minSize, maxSize] : {std::pair<int, int>(1, 1 << 30), std::pair<int, int>(50, 400), std::pair<int, int>(10, 10), std::pair<int, int>(500, 100)}){
+            REQUIRE(fileIDs(file.getSizeRange(minSize, maxSize)) == processorIDs(processor.getComponentsBySize(minSize, maxSize)));
+        }
+    }
+
+    SECTION("IDs removed by a filter are not found"){
+        std::cout << "Testing ComponentFile: lookups after filtering" << std::endl;
+        std::vector<unsigned char> image = ImageGenerator::generate(SyntheticPattern::Noise, 120, 90, 10);
+        PGMimageProcessor processor;
+        REQUIRE(processor.reset(image, 120, 90));
+        int extracted = processor.extractComponents(128, 1);
+        processor.filterComponentsBySize(3, 1000);
+        REQUIRE(processor.getComponentCount() < extracted);
+        REQUIRE(processor.writeComponentFile("output/test_components"));
+
+        ComponentFile file;
+        REQUIRE(file.open("output/test_components.ccx"));
+        std::vector<char> kept(extracted, 0);
+        for(const ConnectedComponent & component : processor.getComponents()){
+            kept[component.getID()] = 1;
+        }
+        bool matches = true;
+        for(int id = 0; id < extracted; ++id){
+            const ComponentFile::Record * record = file.findByID(id);
+            matches = matches && (kept[id] ? record != nullptr && record->id == static_cast<uint32_t>(id) : record == nullptr);
+        }
+        REQUIRE(matches);
+        REQUIRE(file.findByID(-1) == nullptr);
+        REQUIRE(file.findByID(extracted) == nullptr);
+    }
+
+    SECTION("Damaged files and other files are rejected"){
+        std::cout << "Testing ComponentFile: invalid files" << std::endl;
+        std::vector<unsigned char> image = ImageGenerator::generate(SyntheticPattern::Blobs, 100, 80, 11);
+        PGMimageProcessor processor;
+        REQUIRE(processor.reset(image, 100, 80));
+        processor.extractComponents(128, 1);
+        REQUIRE(processor.writeComponentFile("output/test_components"));
+
+        std::ifstream in("output/test_components.ccx", std::ios::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        auto rewrite = [](const std::vector<char> & contents){
+            std::ofstream out("output/test_components_damaged.ccx", std::ios::binary);
+            out.write(contents.data(), contents.size());
+        };
+
+        ComponentFile file;
+        std::vector<char> truncated(bytes.begin(), bytes.end() - 1);
+        rewrite(truncated);
+        REQUIRE_FALSE(file.open("output/test_components_damaged.ccx"));
+        REQUIRE_FALSE(file.isOpen());
+
+        std::vector<char> wrongMagic = bytes;
+        wrongMagic[0] = 'X';
+        rewrite(wrongMagic);
+        REQUIRE_FALSE(file.open("output/test_components_damaged.ccx"));
+
+        std::vector<char> tooManyRuns = bytes;
+        ComponentFile::Header header;
+        std::memcpy(&header, tooManyRuns.data(), sizeof(header));
+        header.runCount += 1;
+        std::memcpy(tooManyRuns.data(), &header, sizeof(header));
+        rewrite(tooManyRuns);
+        REQUIRE_FALSE(file.open("output/test_components_damaged.ccx"));
+
+        REQUIRE(processor.writeComponents<bool>("output/test_components"));
+        REQUIRE_FALSE(file.open("output/test_components.pgm"));
+        REQUIRE_FALSE(file.open("output/no_such_file.ccx"));
+
+        //no components is still a valid file
+        processor.filterComponentsBySize(100 * 80 + 1, 100 * 80 + 1);
+        REQUIRE(processor.getComponentCount() == 0);
+        REQUIRE(processor.writeComponentFile("output/test_components_empty"));
+        REQUIRE(file.open("output/test_components_empty.ccx"));
+        REQUIRE(file.getComponentCount() == 0);
+        REQUIRE(file.getSizeRange(1, 100).empty());
+        REQUIRE(file.findByID(0) == nullptr);
+    }
+
+    SECTION("A moved file keeps its records"){
+        std::cout << "Testing ComponentFile: move" << std::endl;
+        std::vector<unsigned char> image = ImageGenerator::generate(SyntheticPattern::Blobs, 100, 80, 12);
+        PGMimageProcessor processor;
+        REQUIRE(processor.reset(image, 100, 80));
+        processor.extractComponents(128, 1);
+        REQUIRE(processor.getComponentCount() > 0);
+        REQUIRE(processor.writeComponentFile("output/test_components"));
+
+        ComponentFile file;
+        REQUIRE(file.open("output/test_components.ccx"));
+        const ComponentFile::Record * record = file.findByID(0);
+        REQUIRE(record != nullptr);
+
+        ComponentFile moved(std::move(file));
+        REQUIRE_FALSE(file.isOpen());
+        REQUIRE(file.getComponentCount() == 0);
+        REQUIRE(moved.findByID(0) == record);
+
+        ComponentFile assigned;
+        assigned = std::move(moved);
+        REQUIRE_FALSE(moved.isOpen());
+        REQUIRE(assigned.getRuns(*record).size() == record->runCount);
+    }
+}
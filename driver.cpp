@@ -5,22 +5,50 @@
  */
 
 #include "PGMimageProcessor.h"
+#include "StreamingExtractor.h"
+#include "MaxTree.h"
+#include "BatchProcessor.h"
+#include <iomanip>
+#include <chrono>
 
 /**
  * Prints usage instructions for the command-line tool.
  */
 void printUsage() {
-    std::cout << "Usage: findcomp [options] <inputPGMfile>\n";
+    std::cout << "Usage: findcomp [options] <inputPGMfile> [more input files...]\n";
     std::cout << "Options:\n";
     std::cout << "  -m <int>        Set the minimum size for valid components [default = 1]\n";
     std::cout << "  -f <int> <int>  Set min and max component sizes for filtering\n";
-    std::cout << "  -t <int>        Set threshold for component detection [default = 128]\n";
-    std::cout << "  -p              Print all component data\n";
-    std::cout << "  -b <PPMimagename> Produce an output PPM image which is the original image with colour boxes drawn over it to show where each retained component is in the input image." <<std::endl;
+    std::cout << "  -t <int|auto>   Set threshold for component detection, auto picks one from the histogram (Otsu) [default = 128]\n";
+    std::cout << "  -p              Print all component data (size, centroid, orientation, eccentricity and intensity)\n";
+    std::cout << "  -b <PPMimagename> Produce an output PPM image which is the original image with colour boxes drawn over it to show where each retained component is in the input image.\n";
     std::cout << "  -w <string>     Write retained components to a new PGM file\n";
+    std::cout << "  -l <string>     Write the label image (component ID + 1 per pixel, 0 for none) to a 16-bit PGM file\n";
+    std::cout << "  -x <string>     Write the retained components (records, size index and runs) to a binary .ccx file\n";
+    std::cout << "  --engine=<bfs|unionfind|runs> Select the labeling algorithm [default = bfs]\n";
+    std::cout << "  --load=<auto|copy|mmap> Copy the raster into memory or memory map the file (auto maps large files) [default = auto]\n";
+    std::cout << "  -c <4|8>        Connect pixels through their edges only (4) or also their corners (8) [default = 4]\n";
+    std::cout << "  --stream        Read the image a band of rows at a time and report components as they finish (no -w/-b)\n";
+    std::cout << "  -j <int>        Label and render outputs with this many threads, 0 uses every core (selects the unionfind engine) [default = 1]\n";
+    std::cout << "  --batch <dir>   Process every PGM/PPM file in a directory (several input files also start a batch)\n";
+    std::cout << "  --workers <int> Number of files labeled at the same time in a batch, 0 uses every core [default = 0]\n";
+    std::cout << "  --queue-depth <int> Files queued between the read, label and write stages of a batch; at most workers + depth images are held at once [default = 2]\n";
+    std::cout << "  --sweep <t0:t1:step> Report the components at every threshold from t0 to t1 from one max-tree instead of extracting\n";
+    std::cout << "  --stats=json    Print the time, bytes and pixels of each phase, the peak component count and peak memory as one JSON line\n";
+    std::cout << "  -q              Quiet: print only the results (component counts, sweeps and statistics) and errors\n";
+    std::cout << "  -v              Verbose: also print each bounding box and each file written\n";
     exit(1);
 }
 
+/**
+ * Logs the phase counters as one JSON line, shown at every verbosity.
+ */
+void printJSON(const ProcessingStats & stats) {
+    std::ostringstream json;
+    stats.writeJSON(json);
+    Logger::log(Verbosity::Quiet, json.view());
+}
+
 int main(int argc, char* argv[]){
     //ensure the input file is provided
     if(argc <2){
@@ -29,17 +57,33 @@ int main(int argc, char* argv[]){
     }
 
     //input/output filenames and options
-    std::string inputFile = "", outputFile = "", ppmImageName;
+    std::string inputFile = "", outputFile = "", ppmImageName, labelImageName, componentFileName;
+    std::vector<std::string> inputFiles; //every input file, including the contents of --batch directories
+    bool batchMode = false;
+    int workers = 0;
+    int queueDepth = 2;
 
     int minSize = 1;
     int maxSize = std::numeric_limits<int>::max();
     int threshold = 128;
+    bool autoThreshold = false;
+    LabelingEngine engine = LabelingEngine::BFS;
+    bool engineChosen = false;
+    int threads = 1;
+    LoadMode loadMode = LoadMode::Auto;
+    int connectivity = 4;
 
     //various operations
     bool printComponents = false;
     bool writeOutput = false;
     bool drawBoarder = false;
+    bool writeLabels = false;
+    bool writeComponentFile = false;
     bool filterComponents = false;
+    bool streamImage = false;
+    bool sweepThresholds = false;
+    bool printStats = false;
+    int sweepFrom = 0, sweepTo = 255, sweepStep = 1;
     
     //parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -51,9 +95,17 @@ int main(int argc, char* argv[]){
             minSize = std::stoi(argv[++i]);
             maxSize = std::stoi(argv[++i]);
         } else if (option == "-t" && i + 1 < argc) {
-            threshold = std::stoi(argv[++i]);
+            std::string value = argv[++i];
+            autoThreshold = (value == "auto");
+            if (!autoThreshold) {
+                threshold = std::stoi(value);
+            }
         } else if (option == "-p") {
             printComponents = true;
+        } else if (option == "-q") {
+            Logger::setVerbosity(Verbosity::Quiet);
+        } else if (option == "-v") {
+            Logger::setVerbosity(Verbosity::Verbose);
         } else if(option == "-b" && i + 1 < argc) {
             drawBoarder = true;
             writeOutput = true; 
@@ -61,19 +113,197 @@ int main(int argc, char* argv[]){
         } else if (option == "-w" && i + 1 < argc) {
             outputFile = argv[++i];
             writeOutput = true;
+        } else if (option == "-l" && i + 1 < argc) {
+            labelImageName = argv[++i];
+            writeLabels = true;
+        } else if (option == "-x" && i + 1 < argc) {
+            componentFileName = argv[++i];
+            writeComponentFile = true;
+        } else if (option == "-c" && i + 1 < argc) {
+            connectivity = std::stoi(argv[++i]);
+            if (connectivity != 4 && connectivity != 8) {
+                std::cerr << "Connectivity must be 4 or 8\n";
+                printUsage();
+            }
+        } else if ((option == "--sweep" && i + 1 < argc) || option.rfind("--sweep=", 0) == 0) {
+            sweepThresholds = true;
+            std::string rangeText = (option == "--sweep") ? argv[++i] : option.substr(8);
+            char separator1 = 0, separator2 = 0;
+            std::istringstream range(rangeText);
+            if (!(range >> sweepFrom >> separator1 >> sweepTo >> separator2 >> sweepStep) || separator1 != ':' || separator2 != ':'
+                || sweepFrom < 0 || sweepTo > 255 || sweepFrom > sweepTo || sweepStep <= 0) {
+                std::cerr << "Invalid sweep range: " << rangeText << " (expected t0:t1:step with 0 <= t0 <= t1 <= 255)\n";
+                printUsage();
+            }
+        } else if (option.rfind("--stats=", 0) == 0) {
+            std::string format = option.substr(8);
+            if (format != "json") {
+                std::cerr << "Unknown stats format: " << format << " (only json is supported)\n";
+                printUsage();
+            }
+            printStats = true;
+        } else if (option == "--stream") {
+            streamImage = true;
+        } else if (option == "-j" && i + 1 < argc) {
+            threads = std::stoi(argv[++i]);
+        } else if (option.rfind("--load=", 0) == 0) {
+            std::string modeName = option.substr(7);
+            if (modeName == "auto") {
+                loadMode = LoadMode::Auto;
+            } else if (modeName == "copy") {
+                loadMode = LoadMode::Copy;
+            } else if (modeName == "mmap") {
+                loadMode = LoadMode::Map;
+            } else {
+                std::cerr << "Unknown load mode: " << modeName << "\n";
+                printUsage();
+            }
+        } else if (option.rfind("--engine=", 0) == 0) {
+            std::string engineName = option.substr(9);
+            engineChosen = true;
+            if (engineName == "bfs") {
+                engine = LabelingEngine::BFS;
+            } else if (engineName == "unionfind") {
+                engine = LabelingEngine::UnionFind;
+            } else if (engineName == "runs") {
+                engine = LabelingEngine::RunLength;
+            } else {
+                std::cerr << "Unknown labeling engine: " << engineName << "\n";
+                printUsage();
+            }
+        } else if (option == "--batch" && i + 1 < argc) {
+            batchMode = true;
+            if (!BatchProcessor::listImages(argv[++i], inputFiles)) {
+                return 1;
+            }
+        } else if (option == "--workers" && i + 1 < argc) {
+            workers = std::stoi(argv[++i]);
+        } else if (option == "--queue-depth" && i + 1 < argc) {
+            queueDepth = std::stoi(argv[++i]);
+            if (queueDepth < 1) {
+                std::cerr << "Queue depth must be at least 1\n";
+                printUsage();
+            }
         } else {
-            inputFile = option;
+            inputFiles.push_back(option);
         }
     }
 
-    if (inputFile.empty()) {
+    if (inputFiles.empty()) {
+        if (batchMode) {
+            std::cerr << "Error: no PGM or PPM files to process.\n";
+            return 1;
+        }
         printUsage();
     }
+    inputFile = inputFiles[0];
+    batchMode = batchMode || inputFiles.size() > 1;
+
+    if (batchMode && (streamImage || sweepThresholds || printComponents)) {
+        std::cerr << "Error: --stream, --sweep and -p work on a single file and cannot be used in a batch.\n";
+        return 1;
+    }
+
+    //label the image band by band without loading it
+    if (streamImage) {
+        if (sweepThresholds) {
+            std::cerr << "Error: --sweep needs the whole image and cannot be used with --stream.\n";
+            return 1;
+        }
+        if (writeOutput || writeLabels || writeComponentFile) {
+            std::cerr << "Error: -w, -b, -l and -x need the whole image and cannot be used with --stream.\n";
+            return 1;
+        }
+        if (autoThreshold) {
+            std::cerr << "Error: -t auto needs the histogram of the whole image and cannot be used with --stream.\n";
+            return 1;
+        }
+        if (printStats) {
+            std::cerr << "Error: --stats times the phases of a whole image and cannot be used with --stream.\n";
+            return 1;
+        }
+
+        int count = 0, smallest = 0, largest = 0;
+        StreamingExtractor extractor;
+        extractor.setConnectivity(connectivity);
+        //only sizes and sums are reported, so the runs of the components are not kept
+        extractor.setKeepRuns(false);
+        int emitted = extractor.extract(inputFile, threshold, minSize, [&](ConnectedComponent component) {
+            if (filterComponents && component.getSize() > maxSize) {
+                return;
+            }
+            if (printComponents) {
+                component.printData();
+            }
+            smallest = (count == 0) ? component.getSize() : std::min(smallest, component.getSize());
+            largest = std::max(largest, component.getSize());
+            count++;
+        });
+        if (emitted < 0) {
+            std::cerr << "Error: Failed to load PGM file.\n";
+            return 1;
+        }
+
+        Logger::log(Verbosity::Quiet, "Components: ", count);
+        Logger::log(Verbosity::Quiet, "Smallest: ", smallest);
+        Logger::log(Verbosity::Quiet, "Largest: ", largest);
+        return 0;
+    }
+
+    //only the union-find engine can label with more than one thread
+    if (threads != 1 && !engineChosen) {
+        engine = LabelingEngine::UnionFind;
+    }
+
+    //process every file on a pool of workers and print a summary line per file
+    if (batchMode) {
+        BatchOptions options;
+        options.threshold = threshold;
+        options.autoThreshold = autoThreshold;
+        options.minSize = minSize;
+        options.maxSize = maxSize;
+        options.filterComponents = filterComponents;
+        options.engine = engine;
+        options.connectivity = connectivity;
+        options.loadMode = loadMode;
+        options.threadsPerFile = threads;
+        options.outputFile = outputFile;
+        options.ppmImageName = drawBoarder ? ppmImageName : "";
+        options.labelImageName = writeLabels ? labelImageName : "";
+        options.componentFileName = writeComponentFile ? componentFileName : "";
+
+        BatchProcessor batch(options, workers, queueDepth);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<BatchResult> results = batch.run(inputFiles, [](const BatchResult & result) {
+            if (!result.success) {
+                Logger::log(Verbosity::Quiet, result.fileName, ": Error: ", result.error);
+                return;
+            }
+            Logger::log(Verbosity::Normal, result.fileName, ": Threshold: ", result.threshold, " Components: ", result.components,
+                        " Smallest: ", result.smallest, " Largest: ", result.largest,
+                        " Time: ", std::fixed, std::setprecision(1), result.milliseconds, " ms");
+        });
+
+        int failed = 0;
+        for (const BatchResult & result : results) {
+            failed += !result.success;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        Logger::log(Verbosity::Quiet, "Files: ", results.size(), " Failed: ", failed, " Workers: ", batch.getWorkerCount(),
+                    " Queue depth: ", batch.getQueueDepth(),
+                    " Total time: ", std::fixed, std::setprecision(2), seconds, " s");
+        if (printStats) {
+            printJSON(batch.getStats());
+        }
+        return failed == 0 ? 0 : 1;
+    }
 
     //load pgm image file
     PGMimageProcessor imageProcessor;
+    imageProcessor.setThreadCount(threads);
+    imageProcessor.setLoadMode(loadMode);
     
-    std::cout << "Reading in file..." << std::endl;
+    Logger::log(Verbosity::Normal, "Reading in file...");
     bool isPPM = imageProcessor.isPPMFile(inputFile);
 
     bool readFile;
@@ -83,26 +313,61 @@ int main(int argc, char* argv[]){
         readFile = imageProcessor.readPGM<false>(inputFile);
     }
     if (!readFile) {
-        std::cerr << "Error: Failed to load PGM file." << std::endl;
+        std::cerr << "Error: Failed to load PGM file.\n";
         return 1;
     }
 
+    //build the component tree once and report every threshold of the sweep from it
+    if (sweepThresholds) {
+        MaxTree tree;
+        if (!tree.build(imageProcessor.getImageData(), imageProcessor.getWidth(), imageProcessor.getHeight(), connectivity)) {
+            return 1;
+        }
+        Logger::log(Verbosity::Normal, "Max-tree nodes: ", tree.getNodeCount());
+        for (int t = sweepFrom; t <= sweepTo; t += sweepStep) {
+            int count = 0, smallest = 0, largest = 0;
+            long long total = 0;
+            for (int size : tree.componentSizes(static_cast<unsigned char>(t), minSize)) {
+                if (filterComponents && size > maxSize) {
+                    continue;
+                }
+                smallest = (count == 0) ? size : std::min(smallest, size);
+                largest = std::max(largest, size);
+                total += size;
+                count++;
+            }
+            Logger::log(Verbosity::Quiet, "Threshold ", t, ": Components: ", count, " Smallest: ", smallest, " Largest: ", largest,
+                        " Mean: ", (count == 0 ? 0 : total / count));
+        }
+        if (printStats) {
+            printJSON(imageProcessor.getStats());
+        }
+        return 0;
+    }
+
+    //pick the threshold from the histogram counted while reading
+    if (autoThreshold) {
+        threshold = imageProcessor.getOtsuThreshold();
+        Logger::log(Verbosity::Normal, "Otsu threshold: ", threshold);
+    }
+
     //extract components above the threshold and minimum size
-    int numComponents = imageProcessor.extractComponents(threshold, minSize);
-    std::cout << "Extracted Components: " << numComponents <<std::endl;
+    int numComponents = imageProcessor.extractComponents(threshold, minSize, engine, connectivity);
+    Logger::log(Verbosity::Normal, "Extracted Components: ", numComponents);
     
     //optionally filter components by range
     if(filterComponents){
         int filtered = imageProcessor.filterComponentsBySize( minSize, maxSize);
-        std::cout << "Filtered Components: " << filtered <<std::endl;
+        Logger::log(Verbosity::Normal, "Filtered Components: ", filtered);
     }
 
     //optionally print all the components
     if (printComponents) {
-        for (const std::shared_ptr<ConnectedComponent> & component : imageProcessor.getComponents()) { 
-            imageProcessor.printComponentData(*component);
+        Logger::flush(); //the components are printed straight to std::cout, after the lines logged so far
+        for (const ConnectedComponent & component : imageProcessor.getComponents()) { 
+            imageProcessor.printComponentData(component);
         }
-        std::cout << "Printed Components" <<std::endl;
+        Logger::log(Verbosity::Normal, "Printed Components");
 
     }
     
@@ -111,7 +376,7 @@ int main(int argc, char* argv[]){
         bool success = success = imageProcessor.writeComponents<bool>(outputFile);
         
         if (!success) {
-            std::cerr << "Error writing PGM output file: " << outputFile << std::endl;
+            std::cerr << "Error writing PGM output file: " << outputFile << "\n";
         }
     }
 
@@ -119,14 +384,32 @@ int main(int argc, char* argv[]){
     if (drawBoarder) {
         bool success = imageProcessor.writeComponents<bool, true>(ppmImageName);
         if (!success) {
-            std::cerr << "Error writing PPM output file with bounding boxes: " << ppmImageName << std::endl;
+            std::cerr << "Error writing PPM output file with bounding boxes: " << ppmImageName << "\n";
+        }
+    }
+
+    //writes the label image to a 16-bit pgm file
+    if (writeLabels) {
+        if (!imageProcessor.writeLabelImage(labelImageName)) {
+            std::cerr << "Error writing label PGM file: " << labelImageName << "\n";
+        }
+    }
+
+    //writes the components to a binary .ccx file
+    if (writeComponentFile) {
+        if (!imageProcessor.writeComponentFile(componentFileName)) {
+            std::cerr << "Error writing component file: " << componentFileName << "\n";
         }
     }
 
     //print summary of analysis
-    std::cout << "Components: " << imageProcessor.getComponentCount() <<std::endl;
-    std::cout << "Smallest: " << imageProcessor.getSmallestSize() << std::endl;
-    std::cout << "Largest: " << imageProcessor.getLargestSize() << std::endl;
+    Logger::log(Verbosity::Quiet, "Components: ", imageProcessor.getComponentCount());
+    Logger::log(Verbosity::Quiet, "Smallest: ", imageProcessor.getSmallestSize());
+    Logger::log(Verbosity::Quiet, "Largest: ", imageProcessor.getLargestSize());
 
+    //print the phase counters last, on one line, so they can be scraped from the end of the output
+    if (printStats) {
+        printJSON(imageProcessor.getStats());
+    }
     return 0;
 }
\ No newline at end of file